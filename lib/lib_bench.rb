@@ -0,0 +1,100 @@
+# lib_bench.rb
+#  -- Library ruby script to measure commands.
+
+require 'open3'
+require 'shellwords'
+require 'tempfile'
+
+# bench_command runs a command several times and measures
+# - the wall time
+# - the instructions and cache misses, with `perf stat` if perf is installed and allowed
+# - the calls of malloc/calloc/realloc and the bytes they allocate, with src/misc/tmalloccount.c preloaded
+#   if set_bench_preload gives the library.
+# The median of the runs is taken. Unavailable counts are nil. The wall time includes the start of perf.
+# The results are kept in memory by directory and command line, so each section measures a command once
+# even if it is converted for gfm, html and latex.
+
+BENCH = {preload: nil, runs: 5, results: {}, lock: Mutex.new}
+BENCH_COLUMNS = [[:wall_ms, "wall (ms)"], [:instructions, "instructions"], [:cache_misses, "cache misses"],
+                 [:mallocs, "mallocs"], [:malloc_bytes, "malloc bytes"]]
+
+def set_bench_preload path
+  BENCH[:preload] = path && File.expand_path(path)
+end
+
+def set_bench_runs runs
+  BENCH[:runs] = runs
+end
+
+def perf_available?
+  BENCH[:lock].synchronize do
+    BENCH[:perf] = system("perf stat -x, -e instructions -- true > /dev/null 2>&1") if BENCH[:perf] == nil
+    BENCH[:perf]
+  end
+end
+
+def median values
+  values = values.compact.sort
+  values.empty? ? nil : values[values.size/2]
+end
+
+# Runs the command line once in dir, without a shell. Returns the counts of the run.
+def bench_run_once line, dir
+  argv = Shellwords.split(line)
+  env = {}
+  counts = {}
+  perf_out = Tempfile.new("perf")
+  malloc_out = Tempfile.new("malloc")
+  if BENCH[:preload]
+    env = {"LD_PRELOAD" => BENCH[:preload], "T_MALLOC_COUNT" => malloc_out.path}
+  end
+  if perf_available?
+    argv = ["perf", "stat", "-x,", "-e", "instructions,cache-misses", "-o", perf_out.path, "--"] + argv
+  end
+  start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  _out, status = Open3.capture2e(env, *argv, chdir: dir, stdin_data: "")
+  counts[:wall_ms] = (Process.clock_gettime(Process::CLOCK_MONOTONIC) - start) * 1000.0
+  raise ("#{line} returns error status #{status}.\n") unless status.success?
+  File.foreach(perf_out.path) do |l|
+    value, _unit, event = l.split(",")
+    counts[:instructions] = value.to_i if event.to_s.start_with?("instructions") && value =~ /\A\d+\z/
+    counts[:cache_misses] = value.to_i if event.to_s.start_with?("cache-misses") && value =~ /\A\d+\z/
+  end
+  # each process of the command appends a line
+  lines = File.readlines(malloc_out.path)
+  unless lines.empty?
+    counts[:mallocs] = lines.sum{|l| l.split[0].to_i}
+    counts[:malloc_bytes] = lines.sum{|l| l.split[1].to_i}
+  end
+  counts
+ensure
+  perf_out&.close!
+  malloc_out&.close!
+end
+
+def bench_command line, dir
+  id = "#{File.expand_path(dir)}\0#{line}"
+  result = BENCH[:lock].synchronize { BENCH[:results][id] }
+  return result if result
+  runs = Array.new(BENCH[:runs]){ bench_run_once(line, dir) }
+  result = BENCH_COLUMNS.map{|key, _| [key, median(runs.map{|r| r[key]})]}.to_h
+  BENCH[:lock].synchronize { BENCH[:results][id] = result }
+end
+
+def bench_format value
+  case value
+  when nil then "-"
+  when Float then format("%.2f", value)
+  else value.to_s.reverse.scan(/\d{1,3}/).join(",").reverse
+  end
+end
+
+# A markdown table of the results. rows is an array of [command line, result].
+def bench_table rows
+  head = "|command|" + BENCH_COLUMNS.map{|_, title| "#{title}|"}.join + "\n"
+  align = "|:---|" + BENCH_COLUMNS.map{"---:|"}.join + "\n"
+  body = rows.map do |line, result|
+    "|`#{line}`|" + BENCH_COLUMNS.map{|key, _| "#{bench_format(result[key])}|"}.join + "\n"
+  end
+  head + align + body.join
+end
@@ -1,17 +1,21 @@
 # lib_gen_main_tex.rb
 #  -- Library ruby script to generate main.tex.
 
+require_relative 'lib_pandoc.rb'
+
 def basename(file, suffix=nil)
   suffix ? File.basename(file, suffix) : File.basename(file)
 end
 
-def gen_main_tex directory, abstractfile, texfiles, appendixfiles=nil
+def gen_main_tex directory, abstractfile, texfiles, appendixfiles=nil, cache_dir=nil
   #  parameter: directory: the destination directory to put generated files.
   #             texfiles: an array of latex files. Each of them is "secXX.tex" where XX is digits.
+  #             cache_dir: the directory to keep sample.tex for the pandoc version, if given.
 
   # ------ Create helper.tex ------
   # Get preamble from a latex file generated by pandoc.
   #  1. Generate sample latex file by `pandoc -s --listings -o sample.tex sample.md`
+  #     It is cached by the pandoc version, so pandoc runs only the first time.
   #  2. Extract the preamble of sample.tex.
   #  3. Add geometry package.
 
@@ -33,12 +37,7 @@ int main(int argc, char **argv) {
 
 EOS
 
-  File.write "sample.md", sample_md
-  stat = system("pandoc", "-s", "--listings", "-o", "sample.tex", "sample.md")
-  File.delete("sample.md")
-  raise ("pandoc retuns error status #{$?}.\n") unless stat == true
-  sample_tex = File.read("sample.tex")
-  File.delete("sample.tex")
+  sample_tex = pandoc_latex(sample_md, cache_dir)
   preamble = sample_tex.partition(/^\\begin{document}.*?\n/)[0]
   preamble.gsub!(/^\\documentclass\[.*?\]\{.*?\}.*?\n/m,"")
   preamble.gsub!(/^\\usepackage\[.*?\]\{geometry\}.*?\n/,"")
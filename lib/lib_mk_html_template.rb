@@ -1,6 +1,7 @@
 # mk_html_template
+# The template is written to path. Tasks running in parallel must give different paths.
 
-def mk_html_template(home, sec_prev, sec_next)
+def mk_html_template(home, sec_prev, sec_next, path="docs/template.html")
   template = <<~EOS
   <!DOCTYPE html>
   <html lang="en">
@@ -130,5 +131,5 @@ $body$
     i = sec_next.match(/\d+/).to_a[0]
     template = template.sub(/@@@next/, "<li class=\"nav-item\">\n<a class=\"nav-link\" href=\"#{sec_next}\">Next: section#{i}</a>\n</li>\n")
   end
-  File.write("docs/template.html", template)
+  File.write(path, template)
 end
@@ -0,0 +1,142 @@
+# lib_pandoc.rb
+#  -- Library ruby script to run pandoc for many files.
+
+require 'digest'
+require 'etc'
+require 'fileutils'
+require 'open3'
+require 'tmpdir'
+
+# Starting pandoc takes longer than converting a section, so the conversions are queued by pandoc_queue
+# and run together by pandoc_flush.
+# Pandoc 3 and later can run a lua script (`pandoc lua`), which reads and writes many files in one process.
+# Then the queue is split into one job list per processor and each list is converted by one pandoc process.
+# Older pandoc, or PANDOC_BATCH=0 in the environment, runs one pandoc process for each file as before.
+# Each format has its own queue, so the html task and the tex task, which run in parallel, flush only their own jobs.
+# A flush of a format waits for another flush of the same format, so its outputs are written when it returns.
+
+PANDOC = {queues: {}, flushing: {}, lock: Mutex.new, version: nil, samples: {}}
+
+# A job list has a line for each file: output, input, format, template, listings (1 or 0) and title, separated by tabs.
+# The options are the same as the command line options, so the outputs are the same as the ones of `pandoc -o`.
+PANDOC_BATCH_LUA = <<~'EOS'
+  local function read(path)
+    local f = assert(io.open(path, "rb"))
+    local s = f:read("a")
+    f:close()
+    return s
+  end
+
+  for line in io.lines(arg[1]) do
+    local output, input, format, template, listings, title = line:match("^(.-)\t(.-)\t(.-)\t(.-)\t(.-)\t(.*)$")
+    local doc = pandoc.read(read(input), "markdown")
+    local options = {listings = listings == "1"}
+    if template ~= "" then
+      options.template = pandoc.template.compile(read(template), template)
+    end
+    if title ~= "" then
+      doc.meta.title = title
+    end
+    local text = pandoc.write(doc, format, options)
+    -- pandoc adds a newline at the end of a fragment (not standalone) output.
+    if template == "" then
+      text = text .. "\n"
+    end
+    local f = assert(io.open(output, "wb"))
+    f:write(text)
+    f:close()
+  end
+EOS
+
+# The first line of `pandoc --version`, such as "pandoc 3.1.3".
+def pandoc_version
+  PANDOC[:lock].synchronize do
+    PANDOC[:version] ||= begin
+      out, status = Open3.capture2("pandoc", "--version")
+      raise ("pandoc retuns error status #{status}.\n") unless status.success?
+      out.lines.first.to_s.chomp
+    end
+  end
+end
+
+def pandoc_batch?
+  ENV["PANDOC_BATCH"] != "0" && pandoc_version.match(/(\d+)\./).to_a[1].to_i >= 3
+end
+
+def pandoc_args job
+  args = []
+  args += ["-s", "--template=#{job[:template]}"] if job[:template]
+  args << "--metadata=title:#{job[:title]}" if job[:title]
+  args << "--listings" if job[:listings]
+  args + ["-o", job[:output], job[:input]]
+end
+
+# Queues the conversion of the markdown file input to output. format is "html" or "latex".
+#   template: a template file for a standalone output.
+#   listings: true for the listings package in latex.
+#   title:    the title metadata.
+# The block, if given, is called after the conversion, for example to remove the input.
+def pandoc_queue input, output, format, template: nil, listings: false, title: nil, &after
+  job = {input: input, output: output, format: format, template: template, listings: listings, title: title,
+         after: after}
+  PANDOC[:lock].synchronize { (PANDOC[:queues][format] ||= []) << job }
+end
+
+# Runs the queued conversions to format, or to every format if format is nil.
+def pandoc_flush format=nil
+  formats = PANDOC[:lock].synchronize { format ? [format] : PANDOC[:queues].keys }
+  formats.each do |f|
+    flushing = PANDOC[:lock].synchronize { PANDOC[:flushing][f] ||= Mutex.new }
+    flushing.synchronize do
+      jobs = PANDOC[:lock].synchronize { PANDOC[:queues].delete(f) || [] }
+      pandoc_run(jobs) unless jobs.empty?
+    end
+  end
+end
+
+# Converts the jobs, with `pandoc lua` if possible, and calls their blocks.
+def pandoc_run jobs
+  if pandoc_batch?
+    Dir.mktmpdir("pandoc") do |dir|
+      File.write("#{dir}/batch.lua", PANDOC_BATCH_LUA)
+      n = [Etc.nprocessors, jobs.size].min
+      threads = jobs.each_slice((jobs.size + n - 1) / n).each_with_index.map do |slice, i|
+        list = "#{dir}/jobs#{i}"
+        lines = slice.map do |job|
+          [job[:output], job[:input], job[:format], job[:template], job[:listings] ? 1 : 0, job[:title]].join("\t")+"\n"
+        end
+        File.write(list, lines.join)
+        Thread.new do
+          system("pandoc", "lua", "#{dir}/batch.lua", list) or raise ("pandoc retuns error status #{$?}.\n")
+        end
+      end
+      threads.each(&:join)
+    end
+  else
+    jobs.each do |job|
+      system("pandoc", *pandoc_args(job)) or raise ("pandoc retuns error status #{$?}.\n")
+    end
+  end
+  jobs.each{|job| job[:after]&.call}
+end
+
+# Returns the standalone latex file that pandoc converts markdown (a string) to.
+# The outputs are cached by the pandoc version and markdown in memory and, if cache_dir is given, in the directory.
+def pandoc_latex markdown, cache_dir=nil
+  key = Digest::SHA256.hexdigest("#{pandoc_version}\0#{markdown}")
+  tex = PANDOC[:lock].synchronize { PANDOC[:samples][key] }
+  return tex if tex
+  path = cache_dir && "#{cache_dir}/latex-#{key}.tex"
+  if path && File.file?(path)
+    tex = File.read(path)
+  else
+    tex, status = Open3.capture2("pandoc", "-s", "--listings", "-f", "markdown", "-t", "latex", stdin_data: markdown)
+    raise ("pandoc retuns error status #{status}.\n") unless status.success?
+    if path
+      FileUtils.mkdir_p(cache_dir)
+      File.write("#{path}.#{Process.pid}", tex)
+      File.rename("#{path}.#{Process.pid}", path)
+    end
+  end
+  PANDOC[:lock].synchronize { PANDOC[:samples][key] = tex }
+end
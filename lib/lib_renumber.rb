@@ -1,30 +1,29 @@
+def sec_number file
+  file.match(/(\d+(\.\d+)?)\.src\.md$/).to_a[1]
+end
+
+# Renames the section files to sec1.src.md, sec2.src.md, ... in the order of their numbers
+# and changes the links "[Section n](secn.src.md)" in all the files for the new numbers.
+# If the files are numbered 1, 2, ... already, nothing is read or written.
+# A file is written only if its content changes, so that rake doesn't rebuild what depends on the others.
 def renumber secfiles
+  secfiles.sort!{|f,g| sec_number(f).to_f <=> sec_number(g).to_f}
+  new_files = secfiles.each_with_index.map{|file, i| file.sub(/\d+(\.\d+)?\.src\.md$/,"#{i+1}.src.md")}
+  # rule: filename_old, filename_new
+  rename_rule = secfiles.zip(new_files).reject{|old, new| old == new}
+  return if rename_rule.empty?
+
   temp_name = get_temp_name()
-  secfiles.sort!{|f,g| f.match(/\d+(\.\d+)?\.src\.md$/).to_a[0].to_f <=> g.match(/\d+(\.\d+)?\.src\.md$/).to_a[0].to_f}
-  rename_rule = []
-  secfiles.each_with_index do |file, i|
-    # rule: filename_old, temporary_file, filename_new
-    rename_rule << [file, file+temp_name, file.gsub(/\d+(\.\d+)?\.src\.md$/,"#{i+1}.src.md")]
-  end
-  rename_rule.each do |rule|
-    File.rename rule[0], rule[1] if rule[0] != rule[2]
-  end
-  rename_rule.each do |rule|
-    File.rename rule[1], rule[2] if rule[0] != rule[2]
-  end
-  rename_rule.each do |rule|
-    src = File.read(rule[2])
-    changed = false
-    rename_rule.each do |rule|
-      old, temp, new = rule
-      unless old == new
-        old_n = /\d+(\.\d+)?/.match(old).to_a[0]
-        new_n = /\d+(\.\d+)?/.match(new).to_a[0]
-        src = src.gsub(/(\[(S|s)ection *)#{old_n}\]\(sec#{old_n}\.src\.md\)/, "\\1#{new_n}](sec#{new_n})")
-        changed = true
-      end
-    end
-    File.write(rule[2], src) if changed
+  rename_rule.each{|old, new| File.rename old, old+temp_name}
+  rename_rule.each{|old, new| File.rename old+temp_name, new}
+
+  number = rename_rule.map{|old, new| [sec_number(old), sec_number(new)]}.to_h
+  numbers = number.keys.sort_by{|n| -n.length}.map{|n| Regexp.escape(n)}.join("|")
+  link = /(\[(S|s)ection *)(#{numbers})\]\(sec\3\.src\.md\)/
+  new_files.each do |file|
+    src = File.read(file)
+    new_src = src.gsub(link){ "#{$1}#{number[$3]}](sec#{number[$3]}.src.md)" }
+    File.write(file, new_src) if new_src != src
   end
 end
 def get_temp_name
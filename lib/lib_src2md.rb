@@ -1,6 +1,8 @@
 # lib_src2md.rb
 require 'fileutils'
 require 'pathname'
+require 'digest'
+require_relative 'lib_bench.rb'
 include Math
 include FileUtils
 
@@ -95,62 +97,196 @@ class String
   end
 end
 
-def src2md src_path, type
+# dst_path is the output file. It defaults to gfm/, docs/ or latex/ + the basename + .md.
+# Links are always changed for the default directory, so the file can be written elsewhere as an intermediate file.
+def src2md src_path, type, dst_path=nil
   dst_dir = {"gfm"=>"gfm","html"=>"docs","latex"=>"latex"}[type]
-  dst_path = "#{dst_dir}/#{File.basename(src_path, ".src.md")}.md"
+  dst_path = "#{dst_dir}/#{File.basename(src_path, ".src.md")}.md" if dst_path == nil
   src_dir = File.dirname src_path
-  src = File.read(src_path)
-  src = at_if_else(src, type)
-  buf = src.partitions(/^@@@table\n.*?@@@\n/m)
-  src = buf.map{|chunk| chunk=~/\A@@@table/ ? at_table(chunk) : chunk}.join
-  buf = src.partitions(/^@@@include\s*(-(N|n))?.*?@@@\n/m)
-  src = buf.map{|chunk| chunk=~/\A@@@include/ ? at_include(chunk, src_dir, type) : chunk}.join
-  buf = src.partitions(/^@@@shell.*?@@@\n/m)
-  src = buf.map{|chunk| chunk=~/\A@@@shell.*?@@@\n/m ? at_shell(chunk, src_dir) : chunk}.join
-  src = change_link(src, src_dir, type, dst_dir)
-  mkdir_p(dst_dir) unless Dir.exist?(dst_dir)
-  File.write(dst_path, src)
+  mkdir_p(File.dirname(dst_path)) unless Dir.exist?(File.dirname(dst_path))
+  File.open(dst_path, "w") do |file|
+    stage = Src2mdLinks.new(file, src_dir, type, dst_dir)
+    stage = Src2mdDirective.new(stage, /\A@@@shell/, "@@@shell", nil){|chunk| at_shell(chunk, src_dir)}
+    stage = Src2mdDirective.new(stage, /\A@@@bench/, "@@@bench", nil){|chunk| at_bench(chunk, src_dir)}
+    stage = Src2mdDirective.new(stage, /\A@@@include/, "@@@include", /\A@@@include/){|chunk| at_include(chunk, src_dir, type)}
+    stage = Src2mdDirective.new(stage, /\A@@@table\n\z/, "@@@table", /\A@@@table/){|chunk| at_table(chunk)}
+    stage = Src2mdIfElse.new(stage, type)
+    File.foreach(src_path){|line| stage << line}
+    stage.finish
+  end
 end
 
-# @@@if - @@@elif - @@@else - @@@end
-def at_if_else str, type
-  buf = str.each_line.to_a
-  obuf = []
-  if_stat = 0
-  buf.each do |line|
-    if line =~ /^@@@if *(\w+)/ && if_stat == 0
-      if_stat = (type == $1 ? 1 : -1)
+# ---- Streaming conversion ----
+# src2md reads the source line by line and passes each line through a chain of stages:
+#   @@@if-@@@end => @@@table => @@@include => @@@bench => @@@shell => links => the destination file
+# Each stage gets the output of the previous stage, like the passes over the whole text which src2md made before,
+# so the result is the same. A stage holds lines back only while a block is open.
+
+# A stage has << (one line) and finish. emit passes any text to the next stage as lines.
+class Src2mdStage
+  def initialize succ
+    @succ = succ
+    @partial = ""
+  end
+  def emit str
+    str = @partial + str
+    @partial = ""
+    str.each_line do |line|
+      if line.end_with?("\n") then @succ << line else @partial = line end
+    end
+  end
+  def finish
+    @succ << @partial unless @partial.empty?
+    @partial = ""
+    @succ.finish
+  end
+end
+
+# The end of the chain. It writes the lines to io (File or String).
+class Src2mdOutput
+  def initialize io
+    @io = io
+  end
+  def << line
+    @io << line
+  end
+  def finish
+  end
+end
+
+class Src2mdIfElse < Src2mdStage
+  def initialize succ, type
+    super(succ)
+    @type = type
+    @if_stat = 0
+  end
+  def << line
+    if line =~ /^@@@if *(\w+)/ && @if_stat == 0
+      @if_stat = (@type == $1 ? 1 : -1)
     elsif line =~ /^@@@elif *(\w+)/
-      if if_stat == 1
-        if_stat = -2
-      elsif if_stat == -1
-        if_stat = (type == $1 ? 3 : -3)
-      elsif if_stat == -2
-        # if_stat is kept to be -2
-      elsif if_stat == 3
-        if_stat = -2
-      elsif if_stat == -3
-        if_stat = (type == $1 ? 3 : -3)
+      if @if_stat == 1
+        @if_stat = -2
+      elsif @if_stat == -1
+        @if_stat = (@type == $1 ? 3 : -3)
+      elsif @if_stat == -2
+        # @if_stat is kept to be -2
+      elsif @if_stat == 3
+        @if_stat = -2
+      elsif @if_stat == -3
+        @if_stat = (@type == $1 ? 3 : -3)
       end
     elsif line =~ /^@@@else/
-      if if_stat == 1
-        if_stat = -2
-      elsif if_stat == -1
-        if_stat = 2
-      elsif if_stat == -2
-        # if_stat is kept to be -2
-      elsif if_stat == 3
-        if_stat = -2
-      elsif if_stat == -3
-        if_stat = 2
+      if @if_stat == 1
+        @if_stat = -2
+      elsif @if_stat == -1
+        @if_stat = 2
+      elsif @if_stat == -2
+        # @if_stat is kept to be -2
+      elsif @if_stat == 3
+        @if_stat = -2
+      elsif @if_stat == -3
+        @if_stat = 2
       end
     elsif line =~ /^@@@end/
-      if_stat = 0
-    elsif if_stat >= 0
-      obuf << line
+      @if_stat = 0
+    elsif @if_stat >= 0
+      emit line
     end
   end
-  obuf.join
+end
+
+# A block begins with a line matching opener and ends at the first "@@@\n" after the directive word.
+# The block goes to the handler. An unclosed block isn't a block, like a regexp which doesn't match.
+# The passes before called the handler also for the text between two blocks (or after the last one) if it began
+# with chunk_pattern. The chunk is kept for that case.
+class Src2mdDirective < Src2mdStage
+  def initialize succ, opener, word, chunk_pattern, &handler
+    super(succ)
+    @opener = opener
+    @word = word
+    @chunk_pattern = chunk_pattern
+    @handler = handler
+    @block = nil # lines of the open block
+    @chunk = nil # lines of the text which begins with chunk_pattern
+    @chunk_start = true # at the beginning of the text or just after a block
+    @block_at_chunk_start = false
+  end
+  def << line
+    if @block
+      @block << line
+      close_block if line.end_with?("@@@\n")
+    elsif line =~ @opener
+      @block = [line]
+      @block_at_chunk_start = @chunk_start
+      @chunk_start = false
+      close_block if line[@word.size..].end_with?("@@@\n")
+    elsif @chunk
+      @chunk << line
+    elsif @chunk_start && @chunk_pattern && line =~ @chunk_pattern
+      @chunk = [line]
+      @chunk_start = false
+    else
+      @chunk_start = false
+      emit line
+    end
+  end
+  def close_block
+    emit @handler.call(@chunk.join) if @chunk
+    emit @handler.call(@block.join)
+    @chunk = @block = nil
+    @chunk_start = true
+  end
+  def finish
+    if @chunk
+      emit @handler.call((@chunk + (@block || [])).join)
+    elsif @block
+      emit(@block_at_chunk_start && @chunk_pattern ? @handler.call(@block.join) : @block.join)
+    end
+    @chunk = @block = nil
+    super
+  end
+end
+
+# Changes the links outside of fenced code blocks (~~~ - ~~~) and indented code blocks and writes the lines to io.
+# A fence is held back until its closing line. If it isn't closed, its lines are ordinary lines.
+class Src2mdLinks
+  def initialize io, old_dir, type, new_dir
+    raise "Illegal type." unless type == "gfm" || type == "html" || type == "latex"
+    @io = io
+    @old_dir = old_dir
+    @type = type
+    @p_new_dir = Pathname.new(new_dir == nil ? type : new_dir)
+    @fence = nil
+  end
+  def << line
+    if @fence
+      @fence << line
+      if line == "~~~\n"
+        @io << @fence.join
+        @fence = nil
+      end
+    elsif line.start_with?("~~~")
+      @fence = [line]
+    else
+      write_line(line)
+    end
+  end
+  def write_line line
+    @io << (line =~ /\A    .*\n\z/ ? line : change_link_text(line, @old_dir, @type, @p_new_dir))
+  end
+  def finish
+    (@fence || []).each{|line| write_line(line)}
+    @fence = nil
+  end
+end
+
+# @@@if - @@@elif - @@@else - @@@end
+def at_if_else str, type
+  obuf = ""
+  stage = Src2mdIfElse.new(Src2mdOutput.new(obuf), type)
+  str.each_line{|line| stage << line}
+  stage.finish
+  obuf
 end
 
 def get_alignments(separator)
@@ -222,13 +358,14 @@ def at_include str, src_dir, type
     file_func = line.chomp.split(/\s/).reject{|a| a == ""}
     language = lang(file_func[0], type)
     next unless File.file?("#{src_dir}/#{file_func[0]}")
-    src = File.read("#{src_dir}/#{file_func[0]}")
+    source = included_source("#{src_dir}/#{file_func[0]}")
+    src = source.src
     if language == "C"
       if file_func.size >= 2
         a = []
         (1..file_func.size-1).each do |i|
-          func_match_data = src.match(/(.*\n#{file_func[i]}\s*\(.*?\)\s*\{\s*\n(.|\n)*?^\}\s*?\n?)/)
-          a << func_match_data[0] unless func_match_data == nil # func_match_data.to_s is OK, too.
+          func = source.function(file_func[i])
+          a << func unless func == nil
         end
         src = a.join("\n")
       end
@@ -262,6 +399,72 @@ def at_include str, src_dir, type
   obuf.join
 end
 
+# ---- Cache of the included files ----
+# Each file is read once in a build (again only if its mtime or size changes).
+# A function of a C file was found by the regexp
+#   /(.*\n#{name}\s*\(.*?\)\s*\{\s*\n(.|\n)*?^\}\s*?\n?)/
+# over the whole file for each name. Now one scan over the lines makes an index: the offsets of the lines beginning
+# with an identifier, by the identifier, and the offsets of the lines beginning with "}". Only the header part of
+# the regexp is matched at the indexed lines, and the function ends at the first "}" line after the header.
+# That is the same text as the regexp matches.
+
+INCLUDE_CACHE = {files: {}, lock: Mutex.new}
+
+def included_source path
+  stat = File.stat(path)
+  INCLUDE_CACHE[:lock].synchronize do
+    entry = INCLUDE_CACHE[:files][path]
+    if entry == nil || entry[0] != [stat.mtime, stat.size]
+      entry = INCLUDE_CACHE[:files][path] = [[stat.mtime, stat.size], IncludedSource.new(File.read(path))]
+    end
+    entry[1]
+  end
+end
+
+class IncludedSource
+  attr_reader :src
+  def initialize src
+    @src = src
+    @heads = nil # identifier => offsets of the lines before the lines beginning with it
+    @closes = nil # offsets of the lines beginning with "}"
+  end
+  def build_index
+    heads = {}
+    closes = []
+    pos = 0
+    prev = nil
+    @src.each_line do |line|
+      if line.start_with?("}")
+        closes << pos
+      elsif prev && line =~ /\A[A-Za-z_]\w*/
+        (heads[$&] ||= []) << prev
+      end
+      prev = pos
+      pos += line.length
+    end
+    @heads = heads
+    @closes = closes
+  end
+  # The function name with the line before it (the type), or nil if it isn't found.
+  def function name
+    unless name =~ /\A[A-Za-z_]\w*\z/
+      return @src.match(/(.*\n#{name}\s*\(.*?\)\s*\{\s*\n(.|\n)*?^\}\s*?\n?)/).to_a[0]
+    end
+    build_index if @closes == nil
+    header = /\G.*\n#{name}\s*\(.*?\)\s*\{\s*\n/
+    (@heads[name] || []).each do |prev|
+      m = header.match(@src, prev)
+      next if m == nil
+      i = @closes.bsearch_index{|close| close >= m.end(0)}
+      next if i == nil
+      stop = @closes[i] + 1
+      stop += 1 if @src[stop] == "\n"
+      return @src[prev...stop]
+    end
+    nil
+  end
+end
+
 # @@@shell - @@@
 def at_shell str, src_dir
   buf = str.each_line.to_a
@@ -269,12 +472,124 @@ def at_shell str, src_dir
   obuf = ["~~~\n"]
   buf.each do |line|
     obuf << "$ #{line}"
-    `cd #{src_dir}; #{line.chomp}`.each_line {|l| obuf << l}
+    shell_output(line.chomp, src_dir).each_line {|l| obuf << l}
   end
   obuf << "~~~\n"
   obuf.join
 end
 
+# @@@bench - @@@
+# Each line is a command line, which runs in the directory of the source file without a shell.
+# The block is replaced by a table of the measurements (see lib_bench.rb).
+def at_bench str, src_dir
+  buf = str.each_line.to_a
+  buf.delete_at(0); buf.delete_at(-1)
+  rows = buf.map(&:strip).reject(&:empty?).map{|line| [line, bench_command(line, src_dir)]}
+  bench_table(rows)
+end
+
+# ---- Cache of the @@@shell output ----
+# Each section is converted three times (gfm, html and latex), and the commands usually print the same each time.
+# So the output of a command line is cached under a key, which is the SHA256 of
+# - the directory and the command line
+# - the contents of the files the command line names, that is, its words which are paths of existing files
+#   (relative to the directory, or to the directory of a preceding `cd`)
+# - the names and mtimes of the entries of the directories it names.
+# A command line runs again only if one of them changes.
+# The cache is in memory. If set_shell_cache_dir is called, it is also in that directory and survives the build.
+# shell_cache_report tells which command lines ran and why.
+
+SHELL_CACHE = {memory: {}, inputs: {}, dir: nil, log: [], hits: 0, lock: Mutex.new, key_locks: {}}
+
+def set_shell_cache_dir dir
+  SHELL_CACHE[:dir] = dir
+end
+
+def clear_shell_cache
+  SHELL_CACHE[:lock].synchronize do
+    SHELL_CACHE[:memory].clear; SHELL_CACHE[:inputs].clear; SHELL_CACHE[:log].clear; SHELL_CACHE[:key_locks].clear
+    SHELL_CACHE[:hits] = 0
+  end
+end
+
+# path => digest of the files and directories named by the command line
+def shell_inputs line, src_dir
+  dirs = [src_dir]
+  inputs = {}
+  words = line.split(/[\s;&|<>()'"`=]+/).reject{|w| w == ""}
+  words.each_with_index do |word, i|
+    path = (word.start_with?("/") ? [word] : dirs.map{|dir| File.join(dir, word)}).find{|p| File.exist?(p)}
+    if path == nil
+      next
+    elsif File.file?(path)
+      inputs[path] = Digest::SHA256.file(path).hexdigest
+    elsif File.directory?(path)
+      entries = Dir.children(path).sort.map{|e| "#{e} #{File.mtime(File.join(path, e)).to_f}"}
+      inputs[path] = Digest::SHA256.hexdigest(entries.join("\n"))
+      dirs.unshift(path) if i > 0 && words[i-1] == "cd"
+    end
+  end
+  inputs
+end
+
+def shell_rerun_reason old_inputs, inputs
+  return "new" if old_inputs == nil
+  changed = (old_inputs.keys | inputs.keys).sort.reject{|path| old_inputs[path] == inputs[path]}
+  return "output not cached" if changed.empty?
+  changed.map do |path|
+    if old_inputs[path] == nil then "#{path} added"
+    elsif inputs[path] == nil then "#{path} removed"
+    else "#{path} changed"
+    end
+  end.join(", ")
+end
+
+def shell_output line, src_dir
+  inputs = shell_inputs(line, src_dir)
+  id = Digest::SHA256.hexdigest("#{File.expand_path(src_dir)}\0#{line}")
+  key = Digest::SHA256.hexdigest(([id] + inputs.sort.flatten).join("\0"))
+  cache = SHELL_CACHE
+  dir = cache[:dir]
+  key_lock = cache[:lock].synchronize{ cache[:key_locks][key] ||= Mutex.new }
+  # The same command line is run once even if tasks convert it in parallel.
+  key_lock.synchronize do
+    out = cache[:lock].synchronize{ cache[:memory][key] }
+    if out == nil && dir && File.file?("#{dir}/#{key}.out")
+      out = File.read("#{dir}/#{key}.out")
+    end
+    if out
+      cache[:lock].synchronize{ cache[:memory][key] = out; cache[:hits] += 1 }
+      return out
+    end
+    old_inputs = cache[:lock].synchronize{ cache[:inputs][id] }
+    if old_inputs == nil && dir && File.file?("#{dir}/#{id}.inputs")
+      old_inputs = Marshal.load(File.binread("#{dir}/#{id}.inputs"))
+    end
+    reason = shell_rerun_reason(old_inputs, inputs)
+    out = `cd #{src_dir}; #{line}`
+    if dir
+      mkdir_p(dir, verbose: false)
+      File.write("#{dir}/#{key}.out", out)
+      File.binwrite("#{dir}/#{id}.inputs", Marshal.dump(inputs))
+    end
+    cache[:lock].synchronize do
+      cache[:memory][key] = out
+      cache[:inputs][id] = inputs
+      cache[:log] << "#{src_dir}: #{line}: #{reason}"
+    end
+    out
+  end
+end
+
+# The command lines which ran since the cache was cleared, with the reason. Empty if no @@@shell was converted.
+def shell_cache_report
+  cache = SHELL_CACHE
+  cache[:lock].synchronize do
+    return "" if cache[:log].empty? && cache[:hits] == 0
+    "@@@shell: #{cache[:log].size} run, #{cache[:hits]} cached\n" + cache[:log].map{|l| "  #{l}\n"}.join
+  end
+end
+
 # Change relative links in the secXX.src.md to the one in gfm/secXX.md, html/secXX.html or latex/secXX.tex
 # Example:
 #  src=>gfm:  [Section 1](sec1.src.md) => [Section 1](sec1.md)
@@ -299,71 +614,67 @@ end
 #   src/turtle/turtle_doc.src.md has two possibilities.
 #   It goes to src/turtle/turtle_doc.md or gfm/turtle_doc.md.
 def change_link src, old_dir, type, new_dir=nil
-  raise "Illegal type." unless type == "gfm" || type == "html" || type == "latex"
-  new_dir = type if new_dir == nil
-  p_new_dir = Pathname.new(new_dir)
-  buf = src.partitions(/^~~~.*?^~~~\n/m)
-  buf = buf.map{|chunk| chunk =~ /\A~~~.*?^~~~\n\z/m ? chunk : chunk.partitions(/(^    .*\n)+/)}.flatten
-  # buf = buf.inject([]){|b,e| b.append(*e)}
-  buf = buf.map do |chunk|
-    if (chunk =~ /\A~~~.*?^~~~\n\z/m || chunk =~ /\A(^    .*\n)+\z/)
-      chunk
+  obuf = ""
+  stage = Src2mdLinks.new(obuf, old_dir, type, new_dir)
+  src.each_line{|line| stage << line}
+  stage.finish
+  obuf
+end
+
+# Changes the links in chunk, which is text outside of code blocks.
+def change_link_text chunk, old_dir, type, p_new_dir
+  # change inline codes (`...`) to escape char ("\e"=0x1B) in the link change procedure temporarily.
+  # This avoids the influence of the change in the inline codes.
+  # So, .src.md files must not include escape code (0x1B).
+  codes = chunk.scan(/`.*?`/)
+  chunk = chunk.gsub(/`.*?`/,"\e")
+  b = chunk.partitions(/!?\[.*?\]\(.*?\)(\{.*?\})?/)
+  b = b.map do |c|
+    m = c.match(/(!?\[.*?\])\((.*?)\)(\{.*?\})?/)
+    if m == nil
+      c
     else
-      # change inline codes (`...`) to escape char ("\e"=0x1B) in the link change procedure temporarily.
-      # This avoids the influence of the change in the inline codes.
-      # So, .src.md files must not include escape code (0x1B).
-      codes = chunk.scan(/`.*?`/)
-      chunk = chunk.gsub(/`.*?`/,"\e")
-      b = chunk.partitions(/!?\[.*?\]\(.*?\)(\{.*?\})?/)
-      b = b.map do |c|
-        m = c.match(/(!?\[.*?\])\((.*?)\)(\{.*?\})?/)
-        if m == nil
-          c
-        else
-          name = m[1]
-          target = m[2]
-          size = m[3]
-          if target.include?("\e")
-            c
-          elsif target =~ /\.src\.md$/
-            case type
-            when "gfm"
-              "#{name}(#{File.basename(target).sub(/\.src\.md$/,'.md')})"
-            when "html"
-              "#{name}(#{File.basename(target).sub(/\.src\.md$/,'.html')})"
-            when "latex"
-              name.match(/!?\[(.*?)\]/)[1]
-            end
-          elsif target =~ /^(http|\/)/
-            c
-          elsif name =~ /^!/ # link to an image file
-            n_target = Pathname.new("#{old_dir}/#{target}").relative_path_from(p_new_dir).to_s
-            b_target = File.basename(target)
-            case type
-            when "gfm"
-              "#{name}(#{n_target})"
-            when "html"
-              "#{name}(image/#{b_target})"
-            when "latex"
-              size ? "#{name}(#{n_target})#{size}" : "#{name}(#{target})"
-            end
-          else
-            n_target = Pathname.new("#{old_dir}/#{target}").relative_path_from(p_new_dir).to_s
-            if type == "gfm"
-              "#{name}(#{n_target})"
-            else # remove link
-              name.match(/\[(.*?)\]/)[1]
-            end
-          end
+      name = m[1]
+      target = m[2]
+      size = m[3]
+      if target.include?("\e")
+        c
+      elsif target =~ /\.src\.md$/
+        case type
+        when "gfm"
+          "#{name}(#{File.basename(target).sub(/\.src\.md$/,'.md')})"
+        when "html"
+          "#{name}(#{File.basename(target).sub(/\.src\.md$/,'.html')})"
+        when "latex"
+          name.match(/!?\[(.*?)\]/)[1]
+        end
+      elsif target =~ /^(http|\/)/
+        c
+      elsif name =~ /^!/ # link to an image file
+        n_target = Pathname.new("#{old_dir}/#{target}").relative_path_from(p_new_dir).to_s
+        b_target = File.basename(target)
+        case type
+        when "gfm"
+          "#{name}(#{n_target})"
+        when "html"
+          "#{name}(image/#{b_target})"
+        when "latex"
+          size ? "#{name}(#{n_target})#{size}" : "#{name}(#{target})"
+        end
+      else
+        n_target = Pathname.new("#{old_dir}/#{target}").relative_path_from(p_new_dir).to_s
+        if type == "gfm"
+          "#{name}(#{n_target})"
+        else # remove link
+          name.match(/\[(.*?)\]/)[1]
         end
       end
-      c = b.join
-      a = c.split("\e")
-      i = 0
-      codes.inject([a[0]]){|b, code| i+=1; b.append(code, a[i])}.join
     end
   end
-  buf.join
+  c = b.join
+  a = c.split("\e")
+  i = 0
+  codes.inject([a[0]]){|b, code| i+=1; b.append(code, a[i])}.join
 end
 
 # Color fence code.
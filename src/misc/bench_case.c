@@ -0,0 +1,72 @@
+/* benchmark: byte-at-a-time islower/toupper vs tcase */
+
+#include "tcase.h"
+#include <ctype.h>
+#include <glib-object.h>
+#include <string.h>
+
+#define TEXT_SIZE (64 << 20)
+
+static void
+report (const char *name, gint64 start)
+{
+  double usec = (double)(g_get_monotonic_time () - start);
+  g_print ("%-20s %10.3f ms %8.2f GB/s\n", name, usec / 1000.0, TEXT_SIZE / usec / 1000.0);
+}
+
+/* the loop of toupper1.c before tcase */
+static void
+string_toupper (char *s)
+{
+  for (; *s != '\0'; ++s)
+    {
+      if (islower (*s))
+        {
+          *s = (char)toupper ((int)*s);
+        }
+    }
+}
+
+int
+main (void)
+{
+  const char *words = "The quick brown fox jumps over the lazy dog 0123456789. ";
+  gsize       n     = strlen (words), i;
+  char       *text  = g_malloc (TEXT_SIZE + 1);
+  char       *t;
+  gint64      start;
+
+  for (i = 0; i < TEXT_SIZE; ++i)
+    {
+      text[i] = words[i % n];
+    }
+  text[TEXT_SIZE] = '\0';
+
+  start = g_get_monotonic_time ();
+  string_toupper (text);
+  report ("islower/toupper", start);
+  t_ascii_tolower_inplace (text);
+
+  start = g_get_monotonic_time ();
+  t = g_ascii_strup (text, TEXT_SIZE);
+  report ("g_ascii_strup (copy)", start);
+  g_free (t);
+
+  start = g_get_monotonic_time ();
+  t_ascii_toupper_inplace (text);
+  report ("in place", start);
+  t_ascii_tolower_inplace (text);
+
+  start = g_get_monotonic_time ();
+  t = t_ascii_toupper (text);
+  report ("copy", start);
+  g_free (t);
+
+  start = g_get_monotonic_time ();
+  t = t_utf8_toupper (text, TEXT_SIZE);
+  report ("UTF-8 (ASCII text)", start);
+  g_free (t);
+
+  g_free (text);
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include "ttypeonce.h"
 #include <glib-object.h>
 
 typedef struct _TDouble
@@ -21,22 +22,24 @@ t_double_init (TDouble *self)
 {
 }
 
+static GType
+t_double_register_type (void)
+{
+  GTypeInfo info = {
+    .class_size    = sizeof (TDoubleClass),
+    .class_init    = (GClassInitFunc)t_double_class_init,
+    .instance_size = sizeof (TDouble),
+    .instance_init = (GInstanceInitFunc)t_double_init,
+  };
+  return g_type_register_static (G_TYPE_OBJECT, "TDouble", &info, G_TYPE_FLAG_NONE);
+}
+
 GType
 t_double_get_type (void)
 {
-  static GType type;
+  static gsize type = 0;
 
-  if (!type)
-    {
-      GTypeInfo info = {
-        .class_size    = sizeof (TDoubleClass),
-        .class_init    = (GClassInitFunc)t_double_class_init,
-        .instance_size = sizeof (TDouble),
-        .instance_init = (GInstanceInitFunc)t_double_init,
-      };
-      type = g_type_register_static (G_TYPE_OBJECT, "TDouble", &info, G_TYPE_FLAG_NONE);
-    }
-  return type;
+  return t_type_register_once (&type, t_double_register_type);
 }
 
 #define T_DOUBLE_TYPE (t_double_get_type ())
@@ -0,0 +1,184 @@
+#include "tcase.h"
+#include <string.h>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define T_CASE_X86 1
+#include <immintrin.h>
+#endif
+
+// A byte is in the range [first, first + 25] if (byte - first) is less than 26 as an unsigned number.
+// SSE2 and AVX2 only have signed byte comparisons, so the difference is biased by -128 before comparing.
+// The case of a letter is changed by flipping the bit 0x20.
+
+typedef void (*TCaseKernel) (char *dst, const char *src, gsize len, char first);
+
+static void
+t_case_scalar (char *dst, const char *src, gsize len, char first)
+{
+  gsize i;
+
+  for (i = 0; i < len; ++i)
+    {
+      dst[i] = (guchar)(src[i] - first) < 26 ? src[i] ^ 0x20 : src[i];
+    }
+}
+
+#ifdef T_CASE_X86
+
+static void
+t_case_sse2 (char *dst, const char *src, gsize len, char first)
+{
+  __m128i bias  = _mm_set1_epi8 ((char)(-128 - first));
+  __m128i limit = _mm_set1_epi8 (-128 + 26);
+  __m128i flip  = _mm_set1_epi8 (0x20);
+  __m128i x, mask;
+  gsize   i;
+
+  for (i = 0; i + 16 <= len; i += 16)
+    {
+      x    = _mm_loadu_si128 ((const __m128i *)(src + i));
+      mask = _mm_cmplt_epi8 (_mm_add_epi8 (x, bias), limit);
+      _mm_storeu_si128 ((__m128i *)(dst + i), _mm_xor_si128 (x, _mm_and_si128 (mask, flip)));
+    }
+  t_case_scalar (dst + i, src + i, len - i, first);
+}
+
+__attribute__ ((target ("avx2"))) static void
+t_case_avx2 (char *dst, const char *src, gsize len, char first)
+{
+  __m256i bias  = _mm256_set1_epi8 ((char)(-128 - first));
+  __m256i limit = _mm256_set1_epi8 (-128 + 26);
+  __m256i flip  = _mm256_set1_epi8 (0x20);
+  __m256i x, mask;
+  gsize   i;
+
+  for (i = 0; i + 32 <= len; i += 32)
+    {
+      x    = _mm256_loadu_si256 ((const __m256i *)(src + i));
+      mask = _mm256_cmpgt_epi8 (limit, _mm256_add_epi8 (x, bias));
+      _mm256_storeu_si256 ((__m256i *)(dst + i), _mm256_xor_si256 (x, _mm256_and_si256 (mask, flip)));
+    }
+  t_case_sse2 (dst + i, src + i, len - i, first);
+}
+
+#endif
+
+static TCaseKernel
+t_case_get_kernel (void)
+{
+  static TCaseKernel kernel = NULL;
+  TCaseKernel        k      = g_atomic_pointer_get (&kernel);
+
+  if (G_UNLIKELY (k == NULL))
+    {
+#ifdef T_CASE_X86
+      __builtin_cpu_init ();
+      k = __builtin_cpu_supports ("avx2") ? t_case_avx2 : t_case_sse2;
+#else
+      k = t_case_scalar;
+#endif
+      g_atomic_pointer_set (&kernel, k);
+    }
+  return k;
+}
+
+static char *
+t_case_copy (const char *s, gsize len, char first)
+{
+  char *t = g_malloc (len + 1);
+
+  t_case_get_kernel () (t, s, len, first);
+  t[len] = '\0';
+  return t;
+}
+
+// ------------ ASCII ----------------------------------------------------------------------------------------------- //
+
+void
+t_ascii_toupper_len (char *s, gsize len)
+{
+  g_return_if_fail (s != NULL || len == 0);
+
+  t_case_get_kernel () (s, s, len, 'a');
+}
+
+void
+t_ascii_tolower_len (char *s, gsize len)
+{
+  g_return_if_fail (s != NULL || len == 0);
+
+  t_case_get_kernel () (s, s, len, 'A');
+}
+
+void
+t_ascii_toupper_inplace (char *s)
+{
+  g_return_if_fail (s != NULL);
+
+  t_ascii_toupper_len (s, strlen (s));
+}
+
+void
+t_ascii_tolower_inplace (char *s)
+{
+  g_return_if_fail (s != NULL);
+
+  t_ascii_tolower_len (s, strlen (s));
+}
+
+char *
+t_ascii_toupper (const char *s)
+{
+  g_return_val_if_fail (s != NULL, NULL);
+
+  return t_case_copy (s, strlen (s), 'a');
+}
+
+char *
+t_ascii_tolower (const char *s)
+{
+  g_return_val_if_fail (s != NULL, NULL);
+
+  return t_case_copy (s, strlen (s), 'A');
+}
+
+// ------------ UTF-8 ----------------------------------------------------------------------------------------------- //
+
+static gboolean
+t_case_is_ascii (const char *s, gsize len)
+{
+  guint64 word, acc = 0;
+  gsize   i;
+
+  /* eight bytes at a time, the compiler vectorizes the loop */
+  for (i = 0; i + 8 <= len; i += 8)
+    {
+      memcpy (&word, s + i, 8);
+      acc |= word;
+    }
+  for (; i < len; ++i)
+    {
+      acc |= (guchar)s[i];
+    }
+  return (acc & G_GUINT64_CONSTANT (0x8080808080808080)) == 0;
+}
+
+char *
+t_utf8_toupper (const char *s, gssize len)
+{
+  g_return_val_if_fail (s != NULL, NULL);
+
+  gsize n = len < 0 ? strlen (s) : (gsize)len;
+
+  return t_case_is_ascii (s, n) ? t_case_copy (s, n, 'a') : g_utf8_strup (s, n);
+}
+
+char *
+t_utf8_tolower (const char *s, gssize len)
+{
+  g_return_val_if_fail (s != NULL, NULL);
+
+  gsize n = len < 0 ? strlen (s) : (gsize)len;
+
+  return t_case_is_ascii (s, n) ? t_case_copy (s, n, 'A') : g_utf8_strdown (s, n);
+}
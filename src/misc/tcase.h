@@ -0,0 +1,17 @@
+#pragma once
+
+#include <glib-object.h>
+
+// ASCII case conversion. Only 'a'-'z' and 'A'-'Z' are changed, like islower/toupper in the "C" locale.
+// The copying functions return a newly allocated string, which should be freed with g_free.
+void  t_ascii_toupper_inplace (char *s);
+void  t_ascii_tolower_inplace (char *s);
+void  t_ascii_toupper_len (char *s, gsize len);
+void  t_ascii_tolower_len (char *s, gsize len);
+char *t_ascii_toupper (const char *s);
+char *t_ascii_tolower (const char *s);
+
+// UTF-8 case conversion. len is the length in bytes, or -1 if s is NUL-terminated.
+// ASCII text takes the fast path, text with other characters is converted by g_utf8_strup/g_utf8_strdown.
+char *t_utf8_toupper (const char *s, gssize len);
+char *t_utf8_tolower (const char *s, gssize len);
@@ -0,0 +1,184 @@
+/* test for tcase.c: every case kernel the CPU supports against the per-byte islower/toupper loop of toupper1.c */
+/* tcase.c is included so that the static kernels can be called directly. */
+
+#include "tcase.c"
+#include <ctype.h>
+
+#define MAX_LEN    70
+#define MAX_OFFSET 33
+
+static int n_failed;
+
+static void
+report (const char *message, const char *name, gssize len, gsize offset)
+{
+  if (n_failed++ < 20)
+    {
+      g_print ("%s: %s (length %" G_GSSIZE_FORMAT ", offset %" G_GSIZE_FORMAT ").\n", name, message, len, offset);
+    }
+}
+
+// ------------ Kernels --------------------------------------------------------------------------------------------- //
+
+/* the reference is the loop of toupper1.c, and the same loop with isupper/tolower */
+static void
+reference (char *dst, const char *src, gsize len, char first)
+{
+  gsize i;
+  int   c;
+
+  for (i = 0; i < len; ++i)
+    {
+      c = (guchar)src[i];
+      if (first == 'a')
+        {
+          dst[i] = (char)(islower (c) ? toupper (c) : c);
+        }
+      else
+        {
+          dst[i] = (char)(isupper (c) ? tolower (c) : c);
+        }
+    }
+}
+
+/* Every byte value appears in the source and its position shifts with the offset, so each value is seen by both
+ * the vector loop and the scalar tail. The bytes around dst[offset, offset + len) must not be written. */
+static void
+check_kernel (TCaseKernel kernel, const char *name, char first)
+{
+  char  src[MAX_OFFSET + MAX_LEN + 256], dst[MAX_OFFSET + MAX_LEN + 256], expected[MAX_OFFSET + MAX_LEN + 256];
+  gsize len, offset, i, start;
+
+  for (start = 0; start < 256; start += MAX_LEN)
+    {
+      for (i = 0; i < sizeof src; ++i)
+        {
+          src[i] = (char)(start + i);
+        }
+      for (len = 0; len <= MAX_LEN; ++len)
+        {
+          for (offset = 0; offset < MAX_OFFSET; ++offset)
+            {
+              memset (dst, 0x55, sizeof dst);
+              memset (expected, 0x55, sizeof expected);
+              reference (expected + offset, src + offset, len, first);
+              kernel (dst + offset, src + offset, len, first);
+              if (memcmp (dst, expected, sizeof dst) != 0)
+                {
+                  report (first == 'a' ? "toupper differs from the reference" : "tolower differs from the reference",
+                          name, (gssize)len, offset);
+                }
+              /* in place, as t_ascii_toupper_len calls the kernel */
+              memcpy (dst, src, sizeof dst);
+              memcpy (expected, src, sizeof expected);
+              reference (expected + offset, expected + offset, len, first);
+              kernel (dst + offset, dst + offset, len, first);
+              if (memcmp (dst, expected, sizeof dst) != 0)
+                {
+                  report (first == 'a' ? "in-place toupper differs from the reference"
+                                       : "in-place tolower differs from the reference",
+                          name, (gssize)len, offset);
+                }
+            }
+        }
+    }
+}
+
+static void
+check_kernels (void)
+{
+  check_kernel (t_case_scalar, "scalar", 'a');
+  check_kernel (t_case_scalar, "scalar", 'A');
+#ifdef T_CASE_X86
+  check_kernel (t_case_sse2, "sse2", 'a');
+  check_kernel (t_case_sse2, "sse2", 'A');
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      check_kernel (t_case_avx2, "avx2", 'a');
+      check_kernel (t_case_avx2, "avx2", 'A');
+    }
+  else
+    {
+      g_print ("avx2 isn't supported by this CPU, skipped.\n");
+    }
+#endif
+}
+
+// ------------ UTF-8 ----------------------------------------------------------------------------------------------- //
+
+/* Non-ASCII characters at the start, in the eight-byte words and in the tail of t_case_is_ascii, and strings whose
+ * case mapping changes the length. */
+static const char *utf8_strings[] = {
+  "",
+  "plain ascii text, long enough for the vector loop: 0123456789",
+  "\xc3\xa4rger",
+  "Stra\xc3\x9f" "e",
+  "abcdefgh\xc3\x89t\xc3\xa9",
+  "abcdefghijklmno\xce\xb1\xce\xb2\xce\xb3",
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZ \xce\x91\xce\x92\xce\x93 \xd0\x96\xd0\xb6",
+  "\xc4\xb0stanbul",
+  "mixed \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e text",
+};
+
+/* -1 (nul-terminated), the whole string with an explicit length, and the first half of the characters */
+static gssize
+utf8_length (const char *s, int variant)
+{
+  if (variant == 0)
+    {
+      return -1;
+    }
+  else if (variant == 1)
+    {
+      return (gssize)strlen (s);
+    }
+  return (gssize)(g_utf8_offset_to_pointer (s, g_utf8_strlen (s, -1) / 2) - s);
+}
+
+static void
+check_utf8 (void)
+{
+  const char *s;
+  char       *result, *expected;
+  gssize      len;
+  gsize       i;
+  int         variant;
+
+  for (i = 0; i < G_N_ELEMENTS (utf8_strings); ++i)
+    {
+      s = utf8_strings[i];
+      for (variant = 0; variant < 3; ++variant)
+        {
+          len      = utf8_length (s, variant);
+          result   = t_utf8_toupper (s, len);
+          expected = g_utf8_strup (s, len);
+          if (strcmp (result, expected) != 0)
+            {
+              report ("t_utf8_toupper differs from g_utf8_strup", s, len, 0);
+            }
+          g_free (result);
+          g_free (expected);
+          result   = t_utf8_tolower (s, len);
+          expected = g_utf8_strdown (s, len);
+          if (strcmp (result, expected) != 0)
+            {
+              report ("t_utf8_tolower differs from g_utf8_strdown", s, len, 0);
+            }
+          g_free (result);
+          g_free (expected);
+        }
+    }
+}
+
+int
+main (void)
+{
+  check_kernels ();
+  check_utf8 ();
+  if (n_failed)
+    {
+      g_print ("%d differences\n", n_failed);
+    }
+  return n_failed ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+/* stress test for t_type_register_once: the first use of a type from 64 threads at the same time */
+
+#include "ttypeonce.h"
+#include <glib-object.h>
+#include <time.h>
+
+#define N_THREADS 64
+#define N_ROUNDS  16
+
+typedef struct
+{
+  GObject parent;
+} TStress;
+
+typedef struct
+{
+  GObjectClass parent;
+} TStressClass;
+
+static gsize type_ids[N_ROUNDS];
+static gint  n_registrations[N_ROUNDS];
+static gint  round_index;
+static gint  n_ready;
+static gint  go;
+
+static void
+t_stress_class_init (TStressClass *class)
+{
+}
+
+static void
+t_stress_init (TStress *self)
+{
+}
+
+static GType
+t_stress_register_type (void)
+{
+  GTypeInfo info = {
+    .class_size    = sizeof (TStressClass),
+    .class_init    = (GClassInitFunc)t_stress_class_init,
+    .instance_size = sizeof (TStress),
+    .instance_init = (GInstanceInitFunc)t_stress_init,
+  };
+  int   r    = g_atomic_int_get (&round_index);
+  char *name = g_strdup_printf ("TStress%d", r);
+  GType type;
+
+  g_atomic_int_inc (&n_registrations[r]);
+  /* widen the window in which other threads arrive */
+  g_usleep (1000);
+  type = g_type_register_static (G_TYPE_OBJECT, name, &info, G_TYPE_FLAG_NONE);
+  g_free (name);
+  return type;
+}
+
+static GType
+t_stress_get_type (void)
+{
+  return t_type_register_once (&type_ids[g_atomic_int_get (&round_index)], t_stress_register_type);
+}
+
+static gint64
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+typedef struct
+{
+  GType  type;
+  gint64 first_ns;  /* the first call, which may wait for the registration */
+  gint64 second_ns; /* the next call, which is the fast path */
+} Result;
+
+static gpointer
+worker (gpointer data)
+{
+  Result *result = data;
+  gint64  start;
+
+  g_atomic_int_inc (&n_ready);
+  while (!g_atomic_int_get (&go))
+    ;
+  start            = now_ns ();
+  result->type     = t_stress_get_type ();
+  result->first_ns = now_ns () - start;
+  start            = now_ns ();
+  t_stress_get_type ();
+  result->second_ns = now_ns () - start;
+  return NULL;
+}
+
+int
+main (void)
+{
+  GThread *threads[N_THREADS];
+  Result   results[N_THREADS];
+  gint64   first_max = 0, first_sum = 0, second_max = 0, second_sum = 0;
+  int      r, i, failed = 0;
+
+  for (r = 0; r < N_ROUNDS; ++r)
+    {
+      g_atomic_int_set (&round_index, r);
+      g_atomic_int_set (&n_ready, 0);
+      g_atomic_int_set (&go, FALSE);
+      for (i = 0; i < N_THREADS; ++i)
+        {
+          threads[i] = g_thread_new ("stress", worker, &results[i]);
+        }
+      while (g_atomic_int_get (&n_ready) < N_THREADS)
+        {
+          g_thread_yield ();
+        }
+      g_atomic_int_set (&go, TRUE);
+      for (i = 0; i < N_THREADS; ++i)
+        {
+          g_thread_join (threads[i]);
+          if (results[i].type == 0 || results[i].type != results[0].type)
+            {
+              g_print ("Round %d: thread %d got type %lu, thread 0 got %lu.\n", r, i, results[i].type,
+                       results[0].type);
+              failed = 1;
+            }
+          first_max = MAX (first_max, results[i].first_ns);
+          first_sum += results[i].first_ns;
+          second_max = MAX (second_max, results[i].second_ns);
+          second_sum += results[i].second_ns;
+        }
+      if (n_registrations[r] != 1)
+        {
+          g_print ("Round %d: the type was registered %d times.\n", r, n_registrations[r]);
+          failed = 1;
+        }
+    }
+  g_print ("first use: mean %.1f us, max %.1f us\n", first_sum / 1000.0 / (N_ROUNDS * N_THREADS), first_max / 1000.0);
+  g_print ("fast path: mean %.1f ns, max %.1f ns\n", (double)second_sum / (N_ROUNDS * N_THREADS), (double)second_max);
+  return failed;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glib-object.h>
+
+typedef GType (*TTypeRegisterFunc) (void);
+
+// Calls register_func only once, even if many threads need the type for the first time at the same time.
+// type_id is a static variable initialized to 0. Once the type is registered, the cost is an atomic load.
+static inline GType
+t_type_register_once (gsize *type_id, TTypeRegisterFunc register_func)
+{
+  gsize type = (gsize)g_atomic_pointer_get (type_id);
+
+  if (G_LIKELY (type != 0))
+    {
+      return type;
+    }
+  if (g_once_init_enter (type_id))
+    {
+      g_once_init_leave (type_id, register_func ());
+    }
+  return (gsize)g_atomic_pointer_get (type_id);
+}
@@ -0,0 +1,106 @@
+/* benchmark: deduplication by sorting with t_comparable_cmp vs TComparableSet */
+
+#include "../../tnumber/tdouble.h"
+#include "../../tnumber/tint.h"
+#include "../../tstr/tstr.h"
+#include "tcomparable.h"
+#include "tcomparableset.h"
+#include <glib-object.h>
+
+#define N_ITEMS    1000000
+#define N_DISTINCT 100000
+
+static int
+compare (gconstpointer a, gconstpointer b)
+{
+  return t_comparable_cmp (*(TComparable *const *)a, *(TComparable *const *)b);
+}
+
+/* sorts a copy of the array and counts the runs of equal items */
+static guint
+dedup_by_sort (GPtrArray *items)
+{
+  GPtrArray *sorted = g_ptr_array_copy (items, NULL, NULL);
+  guint      i, n = 0;
+
+  g_ptr_array_sort (sorted, compare);
+  for (i = 0; i < sorted->len; ++i)
+    {
+      if (i == 0 || !t_comparable_eq (g_ptr_array_index (sorted, i - 1), g_ptr_array_index (sorted, i)))
+        {
+          ++n;
+        }
+    }
+  g_ptr_array_unref (sorted);
+  return n;
+}
+
+static guint
+dedup_by_set (GPtrArray *items)
+{
+  TComparableSet *set = t_comparable_set_new ();
+  guint           i, n;
+
+  for (i = 0; i < items->len; ++i)
+    {
+      t_comparable_set_add (set, g_ptr_array_index (items, i));
+    }
+  n = t_comparable_set_size (set);
+  t_comparable_set_free (set);
+  return n;
+}
+
+static gboolean
+run (const char *name, GPtrArray *items)
+{
+  gint64 start;
+  double sort_ms, set_ms;
+  guint  by_sort, by_set;
+
+  start   = g_get_monotonic_time ();
+  by_sort = dedup_by_sort (items);
+  sort_ms = (g_get_monotonic_time () - start) / 1000.0;
+  start   = g_get_monotonic_time ();
+  by_set  = dedup_by_set (items);
+  set_ms  = (g_get_monotonic_time () - start) / 1000.0;
+  g_print ("%-8s sort %10.3f ms, set %10.3f ms, %u distinct\n", name, sort_ms, set_ms, by_set);
+  if (by_sort != by_set)
+    {
+      g_print ("sorting found %u distinct items, but the set has %u.\n", by_sort, by_set);
+      return FALSE;
+    }
+  return TRUE;
+}
+
+int
+main (void)
+{
+  GPtrArray *numbers = g_ptr_array_new_with_free_func (g_object_unref);
+  GPtrArray *strings = g_ptr_array_new_with_free_func (g_object_unref);
+  GRand     *rand    = g_rand_new_with_seed (7);
+  char       s[32];
+  gboolean   ok;
+  int        i, v;
+
+  /* Half of the numbers are TDouble, so the same value is often both a TInt and a TDouble, which are equal. */
+  for (i = 0; i < N_ITEMS; ++i)
+    {
+      v = g_rand_int_range (rand, 0, N_DISTINCT);
+      if (g_rand_boolean (rand))
+        {
+          g_ptr_array_add (numbers, t_int_new_with_value (v));
+        }
+      else
+        {
+          g_ptr_array_add (numbers, t_double_new_with_value (v == 0 && g_rand_boolean (rand) ? -0.0 : v));
+        }
+      g_snprintf (s, sizeof s, "item-%d", v);
+      g_ptr_array_add (strings, t_str_new_with_string (s));
+    }
+  ok = run ("numbers", numbers);
+  ok = run ("strings", strings) && ok;
+  g_ptr_array_unref (numbers);
+  g_ptr_array_unref (strings);
+  g_rand_free (rand);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+/* benchmark: aggregates by t_number_add in a loop vs t_number_stats */
+
+#include "../../tnumber/tdouble.h"
+#include "../../tnumber/tint.h"
+#include "tnumberstats.h"
+#include <glib-object.h>
+
+#define N_NUMBERS 1000000
+
+static void
+report (const char *name, gint64 start, double sum)
+{
+  double usec = (double)(g_get_monotonic_time () - start);
+  g_print ("%-20s %10.3f ms %8.2f ns/number  (sum %f)\n", name, usec / 1000.0, usec * 1000.0 / N_NUMBERS, sum);
+}
+
+int
+main (void)
+{
+  GPtrArray   *numbers = g_ptr_array_new_with_free_func (g_object_unref);
+  double      *doubles = g_new (double, N_NUMBERS);
+  int         *ints    = g_new (int, N_NUMBERS);
+  TNumber     *sum, *t;
+  TNumberStats stats;
+  double       d;
+  gint64       start;
+  int          i;
+
+  for (i = 0; i < N_NUMBERS; ++i)
+    {
+      ints[i]    = i % 1000;
+      doubles[i] = i * 0.25;
+      g_ptr_array_add (numbers, t_double_new_with_value (doubles[i]));
+    }
+
+  /* the old way: one new instance per step */
+  start = g_get_monotonic_time ();
+  sum   = T_NUMBER (t_double_new_with_value (0.0));
+  for (i = 0; i < N_NUMBERS; ++i)
+    {
+      t = t_number_add (sum, g_ptr_array_index (numbers, i));
+      g_object_unref (sum);
+      sum = t;
+    }
+  g_object_get (sum, "value", &d, NULL);
+  g_object_unref (sum);
+  report ("t_number_add loop", start, d);
+
+  start = g_get_monotonic_time ();
+  t_number_stats_array (numbers, &stats, NULL, NULL);
+  report ("stats (GPtrArray)", start, stats.sum);
+
+  start = g_get_monotonic_time ();
+  t_number_stats_double (doubles, N_NUMBERS, &stats);
+  report ("stats (double[])", start, stats.sum);
+
+  start = g_get_monotonic_time ();
+  t_number_stats_int (ints, N_NUMBERS, &stats);
+  report ("stats (int[])", start, stats.sum);
+
+  g_ptr_array_unref (numbers);
+  g_free (doubles);
+  g_free (ints);
+  return 0;
+}
@@ -1,4 +1,8 @@
+#include "../../tnumber/tmetrics.h"
+#include "../../tnumber/ttrace.h"
 #include "tcomparable.h"
+#include <math.h>
+#include <string.h>
 
 static guint t_comparable_signal;
 
@@ -10,11 +14,20 @@ arg_error_default_cb (TComparable *self)
   g_printerr ("\nTComparable: argument error.\n");
 }
 
+// The types which don't implement hash can't be put in a hash table.
+static guint
+t_comparable_default_hash (TComparable *self)
+{
+  g_signal_emit_by_name (self, "arg-error");
+  return 0;
+}
+
 static void
 t_comparable_default_init (TComparableInterface *iface)
 {
   /* virtual function */
-  iface->cmp = NULL;
+  iface->cmp  = NULL;
+  iface->hash = t_comparable_default_hash;
   /* argument error signal */
   iface->arg_error    = arg_error_default_cb;
   t_comparable_signal = g_signal_new (
@@ -31,7 +44,14 @@ t_comparable_cmp (TComparable *self, TComparable *other)
 {
   g_return_val_if_fail (T_IS_COMPARABLE (self), COMPARE_ERROR);
   TComparableInterface *iface = T_COMPARABLE_GET_IFACE (self);
-  return (iface->cmp == NULL ? COMPARE_ERROR : iface->cmp (self, other));
+  int                   result;
+  gint64                start = T_METRICS_BEGIN (T_METRIC_COMPARABLE_CMP);
+
+  T_TRACE2 (comparable_cmp_entry, self, other);
+  result = iface->cmp == NULL ? COMPARE_ERROR : iface->cmp (self, other);
+  T_TRACE1 (comparable_cmp_return, result);
+  T_METRICS_END (T_METRIC_COMPARABLE_CMP, start);
+  return result;
 }
 
 gboolean
@@ -65,3 +85,65 @@ t_comparable_le (TComparable *self, TComparable *other)
   int result = t_comparable_cmp (self, other);
   return (result == -1 || result == 0);
 }
+
+// Items which t_comparable_cmp finds equal have the same hash. So a TInt and a TDouble of the same value have the
+// same hash, and -0.0 has the hash of 0.0. NaN isn't equal to anything, not even to itself, so its hash can be
+// anything. All NaNs get the same one.
+guint
+t_comparable_hash (TComparable *self)
+{
+  g_return_val_if_fail (T_IS_COMPARABLE (self), 0);
+
+  return T_COMPARABLE_GET_IFACE (self)->hash (self);
+}
+
+// ------------ Hash functions -------------------------------------------------------------------------------------- //
+
+#define T_HASH_K G_GUINT64_CONSTANT (0x9E3779B97F4A7C15)
+
+// The finalizer of MurmurHash3: every bit of the input affects every bit of the result.
+static inline guint64
+t_comparable_mix (guint64 x)
+{
+  x ^= x >> 33;
+  x *= G_GUINT64_CONSTANT (0xFF51AFD7ED558CCD);
+  x ^= x >> 33;
+  x *= G_GUINT64_CONSTANT (0xC4CEB9FE1A85EC53);
+  x ^= x >> 33;
+  return x;
+}
+
+guint
+t_comparable_hash_double (double value)
+{
+  guint64 bits;
+
+  if (value == 0.0)
+    {
+      value = 0.0; /* -0.0 */
+    }
+  else if (value != value)
+    {
+      value = NAN;
+    }
+  memcpy (&bits, &value, sizeof bits);
+  return (guint)t_comparable_mix (bits);
+}
+
+// A non-cryptographic hash which reads eight bytes at a time.
+guint
+t_comparable_hash_bytes (const void *data, gsize len)
+{
+  const guchar *p = data;
+  guint64       h = len * T_HASH_K, w;
+
+  for (; len >= 8; p += 8, len -= 8)
+    {
+      memcpy (&w, p, 8);
+      h = (h ^ t_comparable_mix (w)) * T_HASH_K;
+    }
+  w = 0;
+  memcpy (&w, p, len);
+  h = (h ^ t_comparable_mix (w ^ len)) * T_HASH_K;
+  return (guint)t_comparable_mix (h);
+}
@@ -10,6 +10,7 @@ struct _TComparableInterface
 {
   GTypeInterface parent;
   int (*cmp) (TComparable *self, TComparable *other);
+  guint (*hash) (TComparable *self);
   void (*arg_error) (TComparable *self);
 };
 
@@ -19,3 +20,8 @@ gboolean t_comparable_gt (TComparable *self, TComparable *other);
 gboolean t_comparable_lt (TComparable *self, TComparable *other);
 gboolean t_comparable_ge (TComparable *self, TComparable *other);
 gboolean t_comparable_le (TComparable *self, TComparable *other);
+guint    t_comparable_hash (TComparable *self);
+
+/* for the implementations of hash */
+guint t_comparable_hash_double (double value);
+guint t_comparable_hash_bytes (const void *data, gsize len);
@@ -0,0 +1,188 @@
+#include "tcomparableset.h"
+
+// Each slot keeps the hash of its item, so that growing the table doesn't call hash again and most slots which
+// don't match are passed without calling cmp. The table grows to twice its size when it becomes 3/4 full.
+// Removal shifts the following items of the cluster back, so there are no tombstones.
+
+#define T_SET_MIN_CAPACITY 16
+
+typedef struct
+{
+  TComparable *item; /* NULL for an empty slot */
+  guint        hash;
+} TComparableSetSlot;
+
+struct _TComparableSet
+{
+  TComparableSetSlot *slots;
+  guint               mask; /* the capacity - 1, which is a power of two */
+  guint               size;
+};
+
+TComparableSet *
+t_comparable_set_new (void)
+{
+  TComparableSet *set = g_new (TComparableSet, 1);
+
+  set->slots = g_new0 (TComparableSetSlot, T_SET_MIN_CAPACITY);
+  set->mask  = T_SET_MIN_CAPACITY - 1;
+  set->size  = 0;
+  return set;
+}
+
+void
+t_comparable_set_free (TComparableSet *set)
+{
+  guint i;
+
+  g_return_if_fail (set != NULL);
+
+  for (i = 0; i <= set->mask; ++i)
+    {
+      if (set->slots[i].item)
+        {
+          g_object_unref (set->slots[i].item);
+        }
+    }
+  g_free (set->slots);
+  g_free (set);
+}
+
+guint
+t_comparable_set_size (TComparableSet *set)
+{
+  g_return_val_if_fail (set != NULL, 0);
+
+  return set->size;
+}
+
+// Returns the slot of the item equal to item, or the empty slot where it would be put.
+static guint
+t_comparable_set_find (TComparableSet *set, TComparable *item, guint hash)
+{
+  TComparableSetSlot *slots = set->slots;
+  guint               i;
+
+  for (i = hash & set->mask; slots[i].item; i = (i + 1) & set->mask)
+    {
+      if (slots[i].hash == hash && t_comparable_cmp (slots[i].item, item) == 0)
+        {
+          break;
+        }
+    }
+  return i;
+}
+
+static void
+t_comparable_set_grow (TComparableSet *set)
+{
+  TComparableSetSlot *old  = set->slots;
+  guint               mask = set->mask, i, j;
+
+  set->mask  = mask * 2 + 1;
+  set->slots = g_new0 (TComparableSetSlot, set->mask + 1);
+  for (i = 0; i <= mask; ++i)
+    {
+      if (old[i].item)
+        {
+          j = old[i].hash & set->mask;
+          while (set->slots[j].item)
+            {
+              j = (j + 1) & set->mask;
+            }
+          set->slots[j] = old[i];
+        }
+    }
+  g_free (old);
+}
+
+// Adds item if the set has no item equal to it. Returns TRUE if it is added.
+gboolean
+t_comparable_set_add (TComparableSet *set, TComparable *item)
+{
+  guint hash, i;
+
+  g_return_val_if_fail (set != NULL, FALSE);
+  g_return_val_if_fail (T_IS_COMPARABLE (item), FALSE);
+
+  hash = t_comparable_hash (item);
+  i    = t_comparable_set_find (set, item, hash);
+  if (set->slots[i].item)
+    {
+      return FALSE;
+    }
+  if ((set->size + 1) * 4 > (set->mask + 1) * 3)
+    {
+      t_comparable_set_grow (set);
+      i = t_comparable_set_find (set, item, hash);
+    }
+  set->slots[i].item = g_object_ref (item);
+  set->slots[i].hash = hash;
+  ++set->size;
+  return TRUE;
+}
+
+// Returns the item in the set which is equal to item (owned by the set), or NULL.
+TComparable *
+t_comparable_set_lookup (TComparableSet *set, TComparable *item)
+{
+  g_return_val_if_fail (set != NULL, NULL);
+  g_return_val_if_fail (T_IS_COMPARABLE (item), NULL);
+
+  return set->slots[t_comparable_set_find (set, item, t_comparable_hash (item))].item;
+}
+
+gboolean
+t_comparable_set_contains (TComparableSet *set, TComparable *item)
+{
+  return t_comparable_set_lookup (set, item) != NULL;
+}
+
+// Removes the item equal to item. Returns TRUE if there is one.
+gboolean
+t_comparable_set_remove (TComparableSet *set, TComparable *item)
+{
+  TComparableSetSlot *slots;
+  guint               i, j, home;
+
+  g_return_val_if_fail (set != NULL, FALSE);
+  g_return_val_if_fail (T_IS_COMPARABLE (item), FALSE);
+
+  slots = set->slots;
+  i     = t_comparable_set_find (set, item, t_comparable_hash (item));
+  if (slots[i].item == NULL)
+    {
+      return FALSE;
+    }
+  g_object_unref (slots[i].item);
+  /* An item after the hole moves into it unless its home slot is in (i, j], cyclically. */
+  for (j = (i + 1) & set->mask; slots[j].item; j = (j + 1) & set->mask)
+    {
+      home = slots[j].hash & set->mask;
+      if (i <= j ? (home <= i || home > j) : (home <= i && home > j))
+        {
+          slots[i] = slots[j];
+          i        = j;
+        }
+    }
+  slots[i].item = NULL;
+  --set->size;
+  return TRUE;
+}
+
+void
+t_comparable_set_foreach (TComparableSet *set, GFunc func, gpointer user_data)
+{
+  guint i;
+
+  g_return_if_fail (set != NULL);
+  g_return_if_fail (func != NULL);
+
+  for (i = 0; i <= set->mask; ++i)
+    {
+      if (set->slots[i].item)
+        {
+          func (set->slots[i].item, user_data);
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "tcomparable.h"
+#include <glib-object.h>
+
+// A set of TComparable items, which is a hash table with open addressing and linear probing keyed by
+// t_comparable_hash and t_comparable_cmp. It holds a reference to each item.
+// The items must be comparable with each other, for example all TNumber or all TStr, like items sorted with
+// t_comparable_cmp. NaN isn't equal to anything, so every NaN is added.
+typedef struct _TComparableSet TComparableSet;
+
+TComparableSet *t_comparable_set_new (void);
+void            t_comparable_set_free (TComparableSet *set);
+guint           t_comparable_set_size (TComparableSet *set);
+gboolean        t_comparable_set_add (TComparableSet *set, TComparable *item);
+TComparable    *t_comparable_set_lookup (TComparableSet *set, TComparable *item);
+gboolean        t_comparable_set_contains (TComparableSet *set, TComparable *item);
+gboolean        t_comparable_set_remove (TComparableSet *set, TComparable *item);
+void            t_comparable_set_foreach (TComparableSet *set, GFunc func, gpointer user_data);
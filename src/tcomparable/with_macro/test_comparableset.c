@@ -0,0 +1,243 @@
+/* test for TComparableSet: random add/remove/lookup sequences against a GHashTable, and the equality of numbers */
+/* TKey is a comparable type of this test whose hash is given, so that the hashes can collide and the clusters
+ * can wrap around the end of the table. */
+
+#include "../../tnumber/tdouble.h"
+#include "../../tnumber/tint.h"
+#include "tcomparable.h"
+#include "tcomparableset.h"
+#include <glib-object.h>
+#include <math.h>
+
+#define N_OPS 200000
+
+static int n_failed;
+
+static void
+report (const char *message, int key)
+{
+  if (n_failed++ < 20)
+    {
+      g_print ("%s (key %d).\n", message, key);
+    }
+}
+
+// ------------ TKey ------------------------------------------------------------------------------------------------ //
+
+#define T_TYPE_KEY (t_key_get_type ())
+G_DECLARE_FINAL_TYPE (TKey, t_key, T, KEY, GObject)
+
+struct _TKey
+{
+  GObject parent;
+  int     key;
+  guint   hash;
+};
+
+static void t_key_comparable_interface_init (TComparableInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (TKey, t_key, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (T_TYPE_COMPARABLE, t_key_comparable_interface_init))
+
+static int
+t_key_cmp (TComparable *self, TComparable *other)
+{
+  int a = T_KEY (self)->key, b = T_KEY (other)->key;
+
+  return a > b ? 1 : a < b ? -1 : 0;
+}
+
+static guint
+t_key_hash (TComparable *self)
+{
+  return T_KEY (self)->hash;
+}
+
+static void
+t_key_comparable_interface_init (TComparableInterface *iface)
+{
+  iface->cmp  = t_key_cmp;
+  iface->hash = t_key_hash;
+}
+
+static void
+t_key_init (TKey *self)
+{
+}
+
+static void
+t_key_class_init (TKeyClass *class)
+{
+}
+
+/* The hash depends on mode:
+ *   0: spread over the table
+ *   1: one of the last four values, so the home slots are the last four slots of any table and the clusters wrap
+ *   2: the same for every key */
+static TComparable *
+t_key_new (int key, int mode)
+{
+  TKey *k = g_object_new (T_TYPE_KEY, NULL);
+
+  k->key  = key;
+  k->hash = mode == 0 ? (guint)key * 2654435761u : mode == 1 ? G_MAXUINT - (guint)(key & 3) : G_MAXUINT;
+  return T_COMPARABLE (k);
+}
+
+// ------------ Random sequences ------------------------------------------------------------------------------------ //
+
+static void
+count_cb (gpointer item, gpointer user_data)
+{
+  GHashTable *seen = user_data;
+
+  g_hash_table_add (seen, GINT_TO_POINTER (T_KEY (item)->key));
+}
+
+/* compares the set with the reference: size, contains/lookup for every key, and foreach */
+static void
+check_all (TComparableSet *set, GHashTable *reference, int n_keys, int mode)
+{
+  GHashTable  *seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+  TComparable *key, *found;
+  int          i;
+
+  if (t_comparable_set_size (set) != g_hash_table_size (reference))
+    {
+      report ("The size of the set differs from the reference", -1);
+    }
+  for (i = 0; i < n_keys; ++i)
+    {
+      key   = t_key_new (i, mode);
+      found = t_comparable_set_lookup (set, key);
+      if (t_comparable_set_contains (set, key) != g_hash_table_contains (reference, GINT_TO_POINTER (i))
+          || (found != NULL) != g_hash_table_contains (reference, GINT_TO_POINTER (i))
+          || (found != NULL && T_KEY (found)->key != i))
+        {
+          report ("t_comparable_set_contains or lookup differs from the reference", i);
+        }
+      g_object_unref (key);
+    }
+  t_comparable_set_foreach (set, count_cb, seen);
+  if (g_hash_table_size (seen) != g_hash_table_size (reference))
+    {
+      report ("t_comparable_set_foreach doesn't visit the items of the reference", -1);
+    }
+  g_hash_table_unref (seen);
+}
+
+static void
+check_random (GRand *rand, int n_keys, int mode)
+{
+  TComparableSet *set       = t_comparable_set_new ();
+  GHashTable     *reference = g_hash_table_new (g_direct_hash, g_direct_equal);
+  TComparable    *key;
+  gboolean        expected, result;
+  int             i, k, op;
+
+  for (i = 0; i < N_OPS; ++i)
+    {
+      k   = g_rand_int_range (rand, 0, n_keys);
+      key = t_key_new (k, mode);
+      /* more adds than removes until the middle, then the other way around, so the set grows and shrinks */
+      op = g_rand_int_range (rand, 0, 10) + (i < N_OPS / 2 ? 0 : 3);
+      if (op < 6)
+        {
+          expected = g_hash_table_add (reference, GINT_TO_POINTER (k));
+          result   = t_comparable_set_add (set, key);
+        }
+      else if (op < 9)
+        {
+          expected = g_hash_table_remove (reference, GINT_TO_POINTER (k));
+          result   = t_comparable_set_remove (set, key);
+        }
+      else
+        {
+          expected = g_hash_table_contains (reference, GINT_TO_POINTER (k));
+          result   = t_comparable_set_lookup (set, key) != NULL;
+        }
+      if (result != expected)
+        {
+          report (op < 6 ? "t_comparable_set_add differs from the reference"
+                  : op < 9 ? "t_comparable_set_remove differs from the reference"
+                           : "t_comparable_set_lookup differs from the reference",
+                  k);
+        }
+      g_object_unref (key);
+      if (i % (n_keys < 100 ? 10 : 1000) == 0)
+        {
+          check_all (set, reference, n_keys, mode);
+        }
+    }
+  check_all (set, reference, n_keys, mode);
+  t_comparable_set_free (set);
+  g_hash_table_unref (reference);
+}
+
+// ------------ Numbers --------------------------------------------------------------------------------------------- //
+
+static void
+check (gboolean ok, const char *message)
+{
+  if (!ok)
+    {
+      report (message, -1);
+    }
+}
+
+static void
+check_numbers (void)
+{
+  TComparableSet *set = t_comparable_set_new ();
+  TComparable    *one_int, *one_double, *zero, *minus_zero, *zero_int, *nan1, *nan2;
+
+  one_int    = T_COMPARABLE (t_int_new_with_value (1));
+  one_double = T_COMPARABLE (t_double_new_with_value (1.0));
+  zero       = T_COMPARABLE (t_double_new_with_value (0.0));
+  minus_zero = T_COMPARABLE (t_double_new_with_value (-0.0));
+  zero_int   = T_COMPARABLE (t_int_new_with_value (0));
+  nan1       = T_COMPARABLE (t_double_new_with_value (NAN));
+  nan2       = T_COMPARABLE (t_double_new_with_value (NAN));
+
+  check (t_comparable_set_add (set, one_int), "TInt 1 isn't added");
+  check (!t_comparable_set_add (set, one_double), "TDouble 1.0 is added, though TInt 1 is in the set");
+  check (t_comparable_set_lookup (set, one_double) == one_int, "TDouble 1.0 doesn't find TInt 1");
+  check (t_comparable_set_add (set, zero), "TDouble 0.0 isn't added");
+  check (!t_comparable_set_add (set, minus_zero), "TDouble -0.0 is added, though 0.0 is in the set");
+  check (!t_comparable_set_add (set, zero_int), "TInt 0 is added, though 0.0 is in the set");
+  check (t_comparable_set_add (set, nan1), "NaN isn't added");
+  check (t_comparable_set_add (set, nan2), "The second NaN isn't added");
+  check (t_comparable_set_add (set, nan1), "The same NaN isn't added again");
+  check (!t_comparable_set_contains (set, nan1), "The set contains NaN");
+  check (t_comparable_set_size (set) == 5, "The size isn't 5");
+  check (t_comparable_set_remove (set, one_double), "TDouble 1.0 doesn't remove TInt 1");
+  check (!t_comparable_set_contains (set, one_int), "TInt 1 is still in the set");
+  check (t_comparable_set_remove (set, minus_zero), "TDouble -0.0 doesn't remove 0.0");
+  check (t_comparable_set_size (set) == 3, "The size isn't 3");
+
+  t_comparable_set_free (set);
+  g_object_unref (one_int);
+  g_object_unref (one_double);
+  g_object_unref (zero);
+  g_object_unref (minus_zero);
+  g_object_unref (zero_int);
+  g_object_unref (nan1);
+  g_object_unref (nan2);
+}
+
+int
+main (void)
+{
+  GRand *rand = g_rand_new_with_seed (11);
+
+  check_numbers ();
+  check_random (rand, 2000, 0);
+  check_random (rand, 40, 1);
+  check_random (rand, 40, 2);
+  g_rand_free (rand);
+  if (n_failed)
+    {
+      g_print ("%d differences\n", n_failed);
+    }
+  return n_failed ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/* test for tnumberstats.c: sum, mean, variance, min and max against a naive two-pass reference */
+/* The sizes cover the empty and one-element input, the tails which are not multiples of the lanes or the block, and
+ * the inputs large enough to be reduced by several threads. */
+
+#include "../../tnumber/tdouble.h"
+#include "../../tnumber/tint.h"
+#include "tnumberstats.h"
+#include <glib-object.h>
+#include <math.h>
+#include <string.h>
+
+/* must be kept in sync with tnumberstats.c */
+#define BLOCK             4096
+#define THRESHOLD         (1 << 20)
+#define THRESHOLD_OBJECTS (1 << 14)
+
+static int n_failed;
+
+static void
+report (const char *message, const char *name, gsize n)
+{
+  if (n_failed++ < 20)
+    {
+      g_print ("%s: %s (n = %" G_GSIZE_FORMAT ").\n", name, message, n);
+    }
+}
+
+// ------------ Reference ------------------------------------------------------------------------------------------- //
+
+/* abs_sum is the sum of the absolute values, the scale of the rounding errors of the sum */
+typedef struct
+{
+  TNumberStats stats;
+  double       abs_sum;
+} Reference;
+
+static void
+reference (const double *x, gsize n, Reference *r)
+{
+  long double sum = 0.0, abs_sum = 0.0, m2 = 0.0, d;
+  gsize       i;
+
+  memset (r, 0, sizeof (Reference));
+  if (n == 0)
+    {
+      return;
+    }
+  r->stats.min = r->stats.max = x[0];
+  for (i = 0; i < n; ++i)
+    {
+      sum += x[i];
+      abs_sum += fabs (x[i]);
+      r->stats.min = MIN (r->stats.min, x[i]);
+      r->stats.max = MAX (r->stats.max, x[i]);
+    }
+  for (i = 0; i < n; ++i)
+    {
+      d = x[i] - sum / n;
+      m2 += d * d;
+    }
+  r->stats.n        = n;
+  r->stats.sum      = (double)sum;
+  r->stats.mean     = (double)(sum / n);
+  r->stats.variance = (double)(m2 / n);
+  r->abs_sum        = (double)abs_sum;
+}
+
+static gboolean
+close_to (double a, double b, double tolerance)
+{
+  return fabs (a - b) <= tolerance;
+}
+
+static void
+compare (const TNumberStats *stats, const Reference *r, const char *name)
+{
+  gsize  n   = r->stats.n;
+  double tol = 1e-12 * r->abs_sum;
+
+  if (stats->n != n)
+    {
+      report ("n differs from the reference", name, n);
+    }
+  if (!close_to (stats->sum, r->stats.sum, tol))
+    {
+      report ("sum differs from the reference", name, n);
+    }
+  if (!close_to (stats->mean, r->stats.mean, n ? tol / n : 0.0))
+    {
+      report ("mean differs from the reference", name, n);
+    }
+  if (!close_to (stats->variance, r->stats.variance, 1e-9 * r->stats.variance))
+    {
+      report ("variance differs from the reference", name, n);
+    }
+  if (stats->min != r->stats.min || stats->max != r->stats.max)
+    {
+      report ("min or max differs from the reference", name, n);
+    }
+}
+
+// ------------ Buffers --------------------------------------------------------------------------------------------- //
+
+static const gsize sizes[] = {
+  0, 1, 2, 3, 4, 5, 7, 13, BLOCK - 1, BLOCK, BLOCK + 3, 3 * BLOCK + 5, THRESHOLD - 1, THRESHOLD, THRESHOLD + 7,
+};
+
+static void
+check_buffers (GRand *rand)
+{
+  Reference    r;
+  TNumberStats stats;
+  double      *x = g_new (double, THRESHOLD + 7);
+  int         *y = g_new (int, THRESHOLD + 7);
+  gsize        i, k, n;
+
+  for (k = 0; k < G_N_ELEMENTS (sizes); ++k)
+    {
+      n = sizes[k];
+      for (i = 0; i < n; ++i)
+        {
+          x[i] = g_rand_double_range (rand, -1000.0, 1000.0) + 1e6;
+        }
+      reference (x, n, &r);
+      t_number_stats_double (x, n, &stats);
+      compare (&stats, &r, "t_number_stats_double");
+      /* the whole int range, so that the int sums of a block need 64 bits */
+      for (i = 0; i < n; ++i)
+        {
+          y[i] = (int)g_rand_int (rand);
+          x[i] = y[i];
+        }
+      reference (x, n, &r);
+      t_number_stats_int (y, n, &stats);
+      compare (&stats, &r, "t_number_stats_int");
+    }
+  g_free (x);
+  g_free (y);
+}
+
+/* One large value, then blocks whose sum is 1.0, then the large value negated. A naive running sum of the blocks
+ * loses every 1.0 against 1e16, the compensated sum keeps them. */
+static void
+check_kahan (void)
+{
+  gsize        n_blocks = 64, n = (n_blocks + 2) * BLOCK, i;
+  double      *x        = g_new0 (double, n);
+  TNumberStats stats;
+  Reference    r;
+
+  x[0] = 1e16;
+  for (i = BLOCK; i < (n_blocks + 1) * BLOCK; ++i)
+    {
+      x[i] = 1.0 / BLOCK;
+    }
+  x[n - 1] = -1e16;
+  t_number_stats_double (x, n, &stats);
+  if (!close_to (stats.sum, (double)n_blocks, 1e-6))
+    {
+      report ("the compensated sum loses the small values", "t_number_stats_double", n);
+    }
+  if (!close_to (stats.mean, (double)n_blocks / n, 1e-15))
+    {
+      report ("the mean loses the small values", "t_number_stats_double", n);
+    }
+  reference (x, n, &r);
+  if (!close_to (stats.variance, r.stats.variance, 1e-9 * r.stats.variance))
+    {
+      report ("variance differs from the reference", "t_number_stats_double", n);
+    }
+  g_free (x);
+}
+
+// ------------ Arrays of TNumber ----------------------------------------------------------------------------------- //
+
+static const gsize array_sizes[] = {
+  0, 1, 2, 5, BLOCK + 1, THRESHOLD_OBJECTS - 1, THRESHOLD_OBJECTS, THRESHOLD_OBJECTS + 3, 3 * THRESHOLD_OBJECTS + 1,
+};
+
+/* A mix of TInt and TDouble with few distinct values, so that TInt 3 and TDouble 3.0 are both the minimum. min and
+ * max must be the first of the equal elements. */
+static void
+check_arrays (GRand *rand)
+{
+  GPtrArray   *numbers;
+  TNumberStats stats;
+  TNumber     *min, *max;
+  Reference    r;
+  double      *x = g_new (double, 3 * THRESHOLD_OBJECTS + 1);
+  gsize        i, k, n, min_i, max_i;
+  int          v;
+
+  for (k = 0; k < G_N_ELEMENTS (array_sizes); ++k)
+    {
+      n       = array_sizes[k];
+      numbers = g_ptr_array_new_with_free_func (g_object_unref);
+      min_i   = 0;
+      max_i   = 0;
+      for (i = 0; i < n; ++i)
+        {
+          v = g_rand_int_range (rand, 3, 40);
+          if (g_rand_boolean (rand))
+            {
+              x[i] = v;
+              g_ptr_array_add (numbers, t_int_new_with_value (v));
+            }
+          else
+            {
+              x[i] = v == 3 || v == 39 ? v : v + 0.25;
+              g_ptr_array_add (numbers, t_double_new_with_value (x[i]));
+            }
+          min_i = x[i] < x[min_i] ? i : min_i;
+          max_i = x[i] > x[max_i] ? i : max_i;
+        }
+      reference (x, n, &r);
+      if (!t_number_stats_array (numbers, &stats, &min, &max))
+        {
+          report ("t_number_stats_array fails", "t_number_stats_array", n);
+        }
+      compare (&stats, &r, "t_number_stats_array");
+      if (n == 0 ? min != NULL || max != NULL
+                 : min != g_ptr_array_index (numbers, min_i) || max != g_ptr_array_index (numbers, max_i))
+        {
+          report ("min or max isn't the first smallest or largest element", "t_number_stats_array", n);
+        }
+      g_ptr_array_unref (numbers);
+    }
+  g_free (x);
+}
+
+int
+main (void)
+{
+  GRand *rand = g_rand_new_with_seed (7);
+
+  check_buffers (rand);
+  check_kahan ();
+  check_arrays (rand);
+  g_rand_free (rand);
+  if (n_failed)
+    {
+      g_print ("%d differences\n", n_failed);
+    }
+  return n_failed ? 1 : 0;
+}
@@ -1,6 +1,8 @@
-#include "../../tnumber/tint.h"
 #include "../../tnumber/tdouble.h"
+#include "../../tnumber/tint.h"
 #include "../../tnumber/tnumber.h"
+#include "../../tnumber/tnumberarena.h"
+#include "../../tnumber/tnumberinline.h"
 #include "tcomparable.h"
 
 enum
@@ -14,12 +16,6 @@ static GParamSpec *int_properties[N_PROPERTIES] = {
   NULL,
 };
 
-struct _TInt
-{
-  TNumber parent;
-  int     value;
-};
-
 static void t_comparable_interface_init (TComparableInterface *iface);
 
 G_DEFINE_TYPE_WITH_CODE (TInt, t_int, T_TYPE_NUMBER,
@@ -40,12 +36,12 @@ t_int_comparable_cmp (TComparable *self, TComparable *other)
   s = (double)T_INT (self)->value;
   if (T_IS_INT (other))
     {
-      g_object_get (other, "value", &i, NULL);
+      i = t_int_get_value (T_INT (other));
       o = (double)i;
     }
   else
     {
-      g_object_get (other, "value", &o, NULL);
+      o = t_double_get_value (T_DOUBLE (other));
     }
   if (s > o)
     {
@@ -65,10 +61,18 @@ t_int_comparable_cmp (TComparable *self, TComparable *other)
     }
 }
 
+/* the hash of the value as double, so that it agrees with cmp between TInt and TDouble */
+static guint
+t_int_comparable_hash (TComparable *self)
+{
+  return t_comparable_hash_double ((double)T_INT (self)->value);
+}
+
 static void
 t_comparable_interface_init (TComparableInterface *iface)
 {
-  iface->cmp = t_int_comparable_cmp;
+  iface->cmp  = t_int_comparable_cmp;
+  iface->hash = t_int_comparable_hash;
 }
 
 static void
@@ -113,12 +117,12 @@ t_int_init (TInt *self)
   double d;                                                                                                            \
   if (T_IS_INT (other))                                                                                                \
     {                                                                                                                  \
-      g_object_get (T_INT (other), "value", &i, NULL);                                                                 \
+      i = t_int_get_value (T_INT (other));                                                                             \
       return T_NUMBER (t_int_new_with_value (T_INT (self)->value op i));                                               \
     }                                                                                                                  \
   else                                                                                                                 \
     {                                                                                                                  \
-      g_object_get (T_DOUBLE (other), "value", &d, NULL);                                                              \
+      d = t_double_get_value (T_DOUBLE (other));                                                                       \
       return T_NUMBER (t_int_new_with_value (T_INT (self)->value op (int) d));                                         \
     }
 
@@ -156,10 +160,10 @@ t_int_div (TNumber *self, TNumber *other)
 
   if (T_IS_INT (other))
     {
-      g_object_get (T_INT (other), "value", &i, NULL);
+      i = t_int_get_value (T_INT (other));
       if (i == 0)
         {
-          g_signal_emit_by_name (self, "div-by-zero");
+          t_number_div_by_zero (self);
           return NULL;
         }
       else
@@ -169,10 +173,10 @@ t_int_div (TNumber *self, TNumber *other)
     }
   else
     {
-      g_object_get (T_DOUBLE (other), "value", &d, NULL);
+      d = t_double_get_value (T_DOUBLE (other));
       if (d == 0)
         {
-          g_signal_emit_by_name (self, "div-by-zero");
+          t_number_div_by_zero (self);
           return NULL;
         }
       else
@@ -197,10 +201,17 @@ t_int_to_s (TNumber *self)
 
   int i;
 
-  g_object_get (T_INT (self), "value", &i, NULL);
+  i = t_int_get_value (T_INT (self));
   return g_strdup_printf ("%d", i);
 }
 
+static void
+t_int_serialize (TNumber *self, TNumberRecord *record)
+{
+  record->tag   = T_NUMBER_TAG_INT;
+  record->value = T_INT (self)->value;
+}
+
 static void
 t_int_class_init (TIntClass *class)
 {
@@ -208,12 +219,13 @@ t_int_class_init (TIntClass *class)
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
   /* override virtual functions */
-  tnumber_class->add    = t_int_add;
-  tnumber_class->sub    = t_int_sub;
-  tnumber_class->mul    = t_int_mul;
-  tnumber_class->div    = t_int_div;
-  tnumber_class->uminus = t_int_uminus;
-  tnumber_class->to_s   = t_int_to_s;
+  tnumber_class->add       = t_int_add;
+  tnumber_class->sub       = t_int_sub;
+  tnumber_class->mul       = t_int_mul;
+  tnumber_class->div       = t_int_div;
+  tnumber_class->uminus    = t_int_uminus;
+  tnumber_class->to_s      = t_int_to_s;
+  tnumber_class->serialize = t_int_serialize;
 
   gobject_class->set_property = t_int_set_property;
   gobject_class->get_property = t_int_get_property;
@@ -227,6 +239,11 @@ t_int_new_with_value (int value)
 {
   TInt *i;
 
+  if (T_NUMBER_ARENA_ACTIVE () && (i = t_number_arena_take (T_TYPE_INT)) != NULL)
+    {
+      i->value = value;
+      return i;
+    }
   i = g_object_new (T_TYPE_INT, "value", value, NULL);
   return i;
 }
@@ -0,0 +1,358 @@
+#include "tnumberstats.h"
+#include "tcomparable.h"
+#include <math.h>
+#include <string.h>
+
+// The input is reduced block by block. A block is small enough to stay in the L1 cache, so its mean is computed
+// first and then the squared deviations from it, which is numerically stable and still one pass over memory.
+// Within a block each value goes to one of T_STATS_LANES independent accumulators, which lets the compiler use
+// SIMD instructions and sums the block pairwise. The block results are merged with Chan's formula and the sums
+// with Kahan compensation. Large inputs are split into ranges which are reduced in parallel and merged in order.
+
+#define T_STATS_BLOCK             4096
+#define T_STATS_LANES             4
+#define T_STATS_MAX_THREADS       64
+#define T_STATS_THRESHOLD         (1 << 20) /* buffers shorter than this are reduced in the caller's thread */
+#define T_STATS_THRESHOLD_OBJECTS (1 << 14) /* the same for arrays of TNumber */
+
+typedef struct
+{
+  gsize    n;
+  double   sum;
+  double   c; /* Kahan compensation, the true sum is sum - c */
+  double   mean;
+  double   m2; /* sum of the squared deviations from mean */
+  double   min;
+  double   max;
+  gsize    min_index;
+  gsize    max_index;
+  gboolean failed; /* an element of an array isn't a comparable TNumber */
+} TStatsPart;
+
+typedef void (*TStatsKernel) (gconstpointer data, gsize start, gsize end, TStatsPart *part);
+
+typedef struct
+{
+  TStatsKernel  kernel;
+  gconstpointer data;
+  gsize         start;
+  gsize         end;
+  TStatsPart    part;
+} TStatsJob;
+
+// ------------ Kernels --------------------------------------------------------------------------------------------- //
+
+// Reduces x[0..n-1] to block. If part is given and the block holds a new extremum, its first index is located.
+#define T_STATS_BLOCK_FUNC(name, type, sum_type, lo_init, hi_init)                                                     \
+  static void name (const type *x, gsize n, gsize offset, const TStatsPart *part, TStatsPart *block)                   \
+  {                                                                                                                    \
+    sum_type s[T_STATS_LANES];                                                                                         \
+    double   q[T_STATS_LANES], mean, d;                                                                                \
+    type     lo[T_STATS_LANES], hi[T_STATS_LANES];                                                                     \
+    gsize    i, k, m = n - n % T_STATS_LANES;                                                                          \
+                                                                                                                       \
+    for (k = 0; k < T_STATS_LANES; ++k)                                                                                \
+      {                                                                                                                \
+        s[k]  = 0;                                                                                                     \
+        q[k]  = 0.0;                                                                                                   \
+        lo[k] = lo_init;                                                                                               \
+        hi[k] = hi_init;                                                                                               \
+      }                                                                                                                \
+    for (i = 0; i < m; i += T_STATS_LANES)                                                                             \
+      {                                                                                                                \
+        for (k = 0; k < T_STATS_LANES; ++k)                                                                            \
+          {                                                                                                            \
+            s[k] += x[i + k];                                                                                          \
+            lo[k] = x[i + k] < lo[k] ? x[i + k] : lo[k];                                                               \
+            hi[k] = x[i + k] > hi[k] ? x[i + k] : hi[k];                                                               \
+          }                                                                                                            \
+      }                                                                                                                \
+    for (; i < n; ++i)                                                                                                 \
+      {                                                                                                                \
+        s[0] += x[i];                                                                                                  \
+        lo[0] = x[i] < lo[0] ? x[i] : lo[0];                                                                           \
+        hi[0] = x[i] > hi[0] ? x[i] : hi[0];                                                                           \
+      }                                                                                                                \
+    for (k = 1; k < T_STATS_LANES; ++k)                                                                                \
+      {                                                                                                                \
+        s[0] += s[k];                                                                                                  \
+        lo[0] = lo[k] < lo[0] ? lo[k] : lo[0];                                                                         \
+        hi[0] = hi[k] > hi[0] ? hi[k] : hi[0];                                                                         \
+      }                                                                                                                \
+    mean = (double)s[0] / n;                                                                                           \
+    for (i = 0; i < m; i += T_STATS_LANES)                                                                             \
+      {                                                                                                                \
+        for (k = 0; k < T_STATS_LANES; ++k)                                                                            \
+          {                                                                                                            \
+            d = x[i + k] - mean;                                                                                       \
+            q[k] += d * d;                                                                                             \
+          }                                                                                                            \
+      }                                                                                                                \
+    for (; i < n; ++i)                                                                                                 \
+      {                                                                                                                \
+        d = x[i] - mean;                                                                                               \
+        q[0] += d * d;                                                                                                 \
+      }                                                                                                                \
+    for (k = 1; k < T_STATS_LANES; ++k)                                                                                \
+      {                                                                                                                \
+        q[0] += q[k];                                                                                                  \
+      }                                                                                                                \
+    memset (block, 0, sizeof (TStatsPart));                                                                            \
+    block->n         = n;                                                                                              \
+    block->sum       = (double)s[0];                                                                                   \
+    block->mean      = mean;                                                                                           \
+    block->m2        = q[0];                                                                                           \
+    block->min       = lo[0];                                                                                          \
+    block->max       = hi[0];                                                                                          \
+    block->min_index = offset;                                                                                         \
+    block->max_index = offset;                                                                                         \
+    if (part && (part->n == 0 || block->min < part->min))                                                              \
+      {                                                                                                                \
+        for (i = 0; i < n && x[i] != lo[0]; ++i)                                                                       \
+          ;                                                                                                            \
+        block->min_index = offset + (i < n ? i : 0);                                                                   \
+      }                                                                                                                \
+    if (part && (part->n == 0 || block->max > part->max))                                                              \
+      {                                                                                                                \
+        for (i = 0; i < n && x[i] != hi[0]; ++i)                                                                       \
+          ;                                                                                                            \
+        block->max_index = offset + (i < n ? i : 0);                                                                   \
+      }                                                                                                                \
+  }
+
+T_STATS_BLOCK_FUNC (t_stats_int_block, int, gint64, G_MAXINT, G_MININT)
+T_STATS_BLOCK_FUNC (t_stats_double_block, double, double, INFINITY, -INFINITY)
+
+static int
+t_stats_cmp (GPtrArray *objects, gsize i, gsize j)
+{
+  TComparable *a = T_COMPARABLE (g_ptr_array_index (objects, i));
+  TComparable *b = T_COMPARABLE (g_ptr_array_index (objects, j));
+  return t_comparable_cmp (a, b);
+}
+
+// b is the part which follows a. If objects is given, the extrema are compared with t_comparable_cmp.
+static void
+t_stats_part_add (TStatsPart *a, const TStatsPart *b, GPtrArray *objects)
+{
+  gsize  n;
+  double delta, y, t;
+
+  if (a->failed || b->failed)
+    {
+      a->failed = TRUE;
+      return;
+    }
+  if (b->n == 0)
+    {
+      return;
+    }
+  if (a->n == 0)
+    {
+      *a = *b;
+      return;
+    }
+  n       = a->n + b->n;
+  delta   = b->mean - a->mean;
+  a->m2   = a->m2 + b->m2 + delta * delta * ((double)a->n * b->n / n);
+  a->mean = a->mean + delta * b->n / n;
+  y       = (b->sum - b->c) - a->c;
+  t       = a->sum + y;
+  a->c    = (t - a->sum) - y;
+  a->sum  = t;
+  a->n    = n;
+  if (objects ? t_stats_cmp (objects, b->min_index, a->min_index) < 0 : b->min < a->min)
+    {
+      a->min       = b->min;
+      a->min_index = b->min_index;
+    }
+  if (objects ? t_stats_cmp (objects, b->max_index, a->max_index) > 0 : b->max > a->max)
+    {
+      a->max       = b->max;
+      a->max_index = b->max_index;
+    }
+}
+
+#define T_STATS_KERNEL(name, type, block_func)                                                                         \
+  static void name (gconstpointer data, gsize start, gsize end, TStatsPart *part)                                      \
+  {                                                                                                                    \
+    const type *values = data;                                                                                         \
+    TStatsPart  block;                                                                                                 \
+    gsize       i;                                                                                                     \
+                                                                                                                       \
+    for (i = start; i < end; i += T_STATS_BLOCK)                                                                       \
+      {                                                                                                                \
+        block_func (values + i, MIN (T_STATS_BLOCK, end - i), i, part, &block);                                        \
+        t_stats_part_add (part, &block, NULL);                                                                         \
+      }                                                                                                                \
+  }
+
+T_STATS_KERNEL (t_stats_int_kernel, int, t_stats_int_block)
+T_STATS_KERNEL (t_stats_double_kernel, double, t_stats_double_block)
+
+// The values are gathered into a buffer through the serialize virtual function, which is much cheaper than
+// g_object_get. The extrema are found with t_comparable_cmp.
+static void
+t_stats_array_kernel (gconstpointer data, gsize start, gsize end, TStatsPart *part)
+{
+  TNumber *const *numbers = data;
+  double          buffer[T_STATS_BLOCK];
+  TNumberRecord   record;
+  TNumberClass   *class;
+  TStatsPart      block;
+  gsize           i, j, nb, min_i = start, max_i = start;
+
+  for (i = start; i < end; i += nb)
+    {
+      nb = MIN (T_STATS_BLOCK, end - i);
+      for (j = 0; j < nb; ++j)
+        {
+          if (!T_IS_NUMBER (numbers[i + j]) || !T_IS_COMPARABLE (numbers[i + j]))
+            {
+              part->failed = TRUE;
+              return;
+            }
+          class = T_NUMBER_GET_CLASS (numbers[i + j]);
+          if (class->serialize == NULL)
+            {
+              part->failed = TRUE;
+              return;
+            }
+          class->serialize (numbers[i + j], &record);
+          buffer[j] = record.value;
+          if (t_comparable_cmp (T_COMPARABLE (numbers[i + j]), T_COMPARABLE (numbers[min_i])) < 0)
+            {
+              min_i = i + j;
+            }
+          if (t_comparable_cmp (T_COMPARABLE (numbers[i + j]), T_COMPARABLE (numbers[max_i])) > 0)
+            {
+              max_i = i + j;
+            }
+        }
+      t_stats_double_block (buffer, nb, i, NULL, &block);
+      t_stats_part_add (part, &block, NULL);
+    }
+  part->min_index = min_i;
+  part->max_index = max_i;
+}
+
+// ------------ Reduction ------------------------------------------------------------------------------------------- //
+
+static gpointer
+t_stats_job_run (gpointer data)
+{
+  TStatsJob *job = data;
+
+  job->kernel (job->data, job->start, job->end, &job->part);
+  return NULL;
+}
+
+static void
+t_stats_reduce (TStatsKernel kernel, gconstpointer data, gsize n, gsize threshold, GPtrArray *objects,
+                TStatsPart *result)
+{
+  TStatsJob jobs[T_STATS_MAX_THREADS];
+  GThread  *threads[T_STATS_MAX_THREADS];
+  guint     n_jobs = 1, i;
+  gsize     chunk;
+
+  if (n >= threshold)
+    {
+      n_jobs = CLAMP (g_get_num_processors (), 1, T_STATS_MAX_THREADS);
+    }
+  /* the ranges start at block boundaries, so that the blocks are the same as in a single thread */
+  chunk = (n / n_jobs + T_STATS_BLOCK - 1) / T_STATS_BLOCK * T_STATS_BLOCK;
+  for (i = 0; i < n_jobs; ++i)
+    {
+      memset (&jobs[i], 0, sizeof (TStatsJob));
+      jobs[i].kernel = kernel;
+      jobs[i].data   = data;
+      jobs[i].start  = MIN (i * chunk, n);
+      jobs[i].end    = i == n_jobs - 1 ? n : MIN ((i + 1) * chunk, n);
+    }
+  for (i = 1; i < n_jobs; ++i)
+    {
+      threads[i] = g_thread_new ("t-number-stats", t_stats_job_run, &jobs[i]);
+    }
+  t_stats_job_run (&jobs[0]);
+  memset (result, 0, sizeof (TStatsPart));
+  for (i = 0; i < n_jobs; ++i)
+    {
+      if (i > 0)
+        {
+          g_thread_join (threads[i]);
+        }
+      t_stats_part_add (result, &jobs[i].part, objects);
+    }
+}
+
+static void
+t_stats_part_finish (const TStatsPart *part, TNumberStats *stats)
+{
+  memset (stats, 0, sizeof (TNumberStats));
+  if (part->n == 0)
+    {
+      return;
+    }
+  stats->n        = part->n;
+  stats->sum      = part->sum - part->c;
+  stats->mean     = stats->sum / part->n;
+  stats->variance = part->m2 / part->n;
+  stats->min      = part->min;
+  stats->max      = part->max;
+}
+
+// ------------ API ------------------------------------------------------------------------------------------------- //
+
+void
+t_number_stats_int (const int *values, gsize n, TNumberStats *stats)
+{
+  g_return_if_fail (values != NULL || n == 0);
+  g_return_if_fail (stats != NULL);
+
+  TStatsPart part;
+
+  t_stats_reduce (t_stats_int_kernel, values, n, T_STATS_THRESHOLD, NULL, &part);
+  t_stats_part_finish (&part, stats);
+}
+
+void
+t_number_stats_double (const double *values, gsize n, TNumberStats *stats)
+{
+  g_return_if_fail (values != NULL || n == 0);
+  g_return_if_fail (stats != NULL);
+
+  TStatsPart part;
+
+  t_stats_reduce (t_stats_double_kernel, values, n, T_STATS_THRESHOLD, NULL, &part);
+  t_stats_part_finish (&part, stats);
+}
+
+// numbers is an array of TInt and TDouble. min and max (can be NULL) are set to the first smallest and the first
+// largest element according to t_comparable_cmp. They are owned by the array.
+// Returns FALSE if an element isn't a TNumber implementing TComparable.
+gboolean
+t_number_stats_array (GPtrArray *numbers, TNumberStats *stats, TNumber **min, TNumber **max)
+{
+  g_return_val_if_fail (numbers != NULL, FALSE);
+  g_return_val_if_fail (stats != NULL, FALSE);
+
+  TStatsPart part;
+
+  t_stats_reduce (t_stats_array_kernel, numbers->pdata, numbers->len, T_STATS_THRESHOLD_OBJECTS, numbers, &part);
+  if (part.failed)
+    {
+      g_warning ("t_number_stats_array: an element isn't a comparable TNumber.");
+      return FALSE;
+    }
+  t_stats_part_finish (&part, stats);
+  if (min)
+    {
+      *min = part.n > 0 ? g_ptr_array_index (numbers, part.min_index) : NULL;
+    }
+  if (max)
+    {
+      *max = part.n > 0 ? g_ptr_array_index (numbers, part.max_index) : NULL;
+    }
+  return TRUE;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../../tnumber/tnumber.h"
+#include <glib-object.h>
+
+// Aggregates of a set of numbers, computed in one pass without creating TNumber instances.
+// variance is the population variance (divided by n). If n is 0, the other members are 0.0.
+typedef struct
+{
+  gsize  n;
+  double sum;
+  double mean;
+  double variance;
+  double min;
+  double max;
+} TNumberStats;
+
+void     t_number_stats_int (const int *values, gsize n, TNumberStats *stats);
+void     t_number_stats_double (const double *values, gsize n, TNumberStats *stats);
+gboolean t_number_stats_array (GPtrArray *numbers, TNumberStats *stats, TNumber **min, TNumber **max);
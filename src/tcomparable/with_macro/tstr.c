@@ -14,7 +14,9 @@ static GParamSpec *str_properties[N_PROPERTIES] = {
 
 typedef struct
 {
-  char *string;
+  char    *string;
+  guint    hash; /* the hash of string, valid if hash_valid */
+  gboolean hash_valid;
 } TStrPrivate;
 
 static void t_comparable_interface_init (TComparableInterface *iface);
@@ -68,7 +70,8 @@ t_str_real_set_string (TStr *self, const char *s)
     {
       g_free (priv->string);
     }
-  priv->string = g_strdup (s);
+  priv->string     = g_strdup (s);
+  priv->hash_valid = FALSE;
 }
 
 static void
@@ -120,10 +123,25 @@ t_str_comparable_cmp (TComparable *self, TComparable *other)
   return result;
 }
 
+/* The hash is computed once and kept until the string is set again. NULL has the hash 0. */
+static guint
+t_str_comparable_hash (TComparable *self)
+{
+  TStrPrivate *priv = t_str_get_instance_private (T_STR (self));
+
+  if (!priv->hash_valid)
+    {
+      priv->hash       = priv->string ? t_comparable_hash_bytes (priv->string, strlen (priv->string)) : 0;
+      priv->hash_valid = TRUE;
+    }
+  return priv->hash;
+}
+
 static void
 t_comparable_interface_init (TComparableInterface *iface)
 {
-  iface->cmp = t_str_comparable_cmp;
+  iface->cmp  = t_str_comparable_cmp;
+  iface->hash = t_str_comparable_hash;
 }
 
 static void
@@ -131,7 +149,8 @@ t_str_init (TStr *self)
 {
   TStrPrivate *priv = t_str_get_instance_private (self);
 
-  priv->string = NULL;
+  priv->string     = NULL;
+  priv->hash_valid = FALSE;
 }
 
 static void
@@ -1,30 +1,35 @@
+#include "../../misc/ttypeonce.h"
+#include "../../tnumber/ttrace.h"
 #include "tcomparable.h"
 
 static guint t_comparable_signal;
 
 /*G_DEFINE_INTERFACE (TComparable, t_comparable, G_TYPE_OBJECT)*/
 static void t_comparable_default_init (TComparableInterface *iface);
+static GType
+t_comparable_register_type (void)
+{
+  GTypeInfo info;
+
+  info.class_size     = sizeof (TComparableInterface);
+  info.base_init      = NULL;
+  info.base_finalize  = NULL;
+  info.class_init     = (GClassInitFunc)t_comparable_default_init;
+  info.class_finalize = NULL;
+  info.class_data     = NULL;
+  info.instance_size  = 0;
+  info.n_preallocs    = 0;
+  info.instance_init  = NULL;
+  info.value_table    = NULL;
+  return g_type_register_static (G_TYPE_INTERFACE, "TComparable", &info, 0);
+}
+
 GType
 t_comparable_get_type (void)
 {
-  static GType type = 0;
-  GTypeInfo    info;
+  static gsize type = 0;
 
-  if (type == 0)
-    {
-      info.class_size     = sizeof (TComparableInterface);
-      info.base_init      = NULL;
-      info.base_finalize  = NULL;
-      info.class_init     = (GClassInitFunc)t_comparable_default_init;
-      info.class_finalize = NULL;
-      info.class_data     = NULL;
-      info.instance_size  = 0;
-      info.n_preallocs    = 0;
-      info.instance_init  = NULL;
-      info.value_table    = NULL;
-      type                = g_type_register_static (G_TYPE_INTERFACE, "TComparable", &info, 0);
-    }
-  return type;
+  return t_type_register_once (&type, t_comparable_register_type);
 }
 
 static void
@@ -52,8 +57,12 @@ t_comparable_cmp (TComparable *self, TComparable *other)
   g_return_val_if_fail (T_IS_COMPARABLE (self), -2);
 
   TComparableInterface *iface = T_COMPARABLE_GET_IFACE (self);
+  int                   result;
 
-  return (iface->cmp == NULL ? -2 : iface->cmp (self, other));
+  T_TRACE2 (comparable_cmp_entry, self, other);
+  result = iface->cmp == NULL ? -2 : iface->cmp (self, other);
+  T_TRACE1 (comparable_cmp_return, result);
+  return result;
 }
 
 gboolean
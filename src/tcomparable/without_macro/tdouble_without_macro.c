@@ -156,7 +156,7 @@ t_double_div (TNumber *self, TNumber *other)
       g_object_get (T_INT (other), "value", &i, NULL);
       if (i == 0)
         {
-          g_signal_emit_by_name (self, "div-by-zero");
+          t_number_div_by_zero (self);
           return NULL;
         }
       else
@@ -169,7 +169,7 @@ t_double_div (TNumber *self, TNumber *other)
       g_object_get (T_DOUBLE (other), "value", &d, NULL);
       if (d == 0)
         {
-          g_signal_emit_by_name (self, "div-by-zero");
+          t_number_div_by_zero (self);
           return NULL;
         }
       else
@@ -198,6 +198,13 @@ t_double_to_s (TNumber *self)
   return g_strdup_printf ("%lf", d);
 }
 
+static void
+t_double_serialize (TNumber *self, TNumberRecord *record)
+{
+  record->tag   = T_NUMBER_TAG_DOUBLE;
+  record->value = T_DOUBLE (self)->value;
+}
+
 static void
 t_double_class_init (TDoubleClass *class)
 {
@@ -205,12 +212,13 @@ t_double_class_init (TDoubleClass *class)
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
   /* override virtual functions */
-  tnumber_class->add    = t_double_add;
-  tnumber_class->sub    = t_double_sub;
-  tnumber_class->mul    = t_double_mul;
-  tnumber_class->div    = t_double_div;
-  tnumber_class->uminus = t_double_uminus;
-  tnumber_class->to_s   = t_double_to_s;
+  tnumber_class->add       = t_double_add;
+  tnumber_class->sub       = t_double_sub;
+  tnumber_class->mul       = t_double_mul;
+  tnumber_class->div       = t_double_div;
+  tnumber_class->uminus    = t_double_uminus;
+  tnumber_class->to_s      = t_double_to_s;
+  tnumber_class->serialize = t_double_serialize;
 
   gobject_class->set_property = t_double_set_property;
   gobject_class->get_property = t_double_get_property;
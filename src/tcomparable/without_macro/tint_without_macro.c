@@ -1,3 +1,4 @@
+#include "../../misc/ttypeonce.h"
 #include "../../tnumber/tdouble.h"
 #include "../../tnumber/tint.h"
 #include "../../tnumber/tnumber.h"
@@ -27,33 +28,37 @@ static void t_comparable_interface_init (TComparableInterface *iface);
 static void t_int_class_init (TIntClass *class);
 static void t_int_init (TInt *self);
 
+static GType
+t_int_register_type (void)
+{
+  const GTypeInfo info = {
+    sizeof (TIntClass),
+    NULL,                                            /* base_init */
+    NULL,                                            /* base_finalize */
+    (GClassInitFunc)t_int_class_init,                /* class_init */
+    NULL,                                            /* class_finalize */
+    NULL,                                            /* class_data */
+    sizeof (TInt),
+    0,                                               /* n_preallocs */
+    (GInstanceInitFunc)t_int_init,                   /* instance_init */
+    NULL                                             /* value table */
+  };
+  const GInterfaceInfo comparable_info = {
+    (GInterfaceInitFunc)t_comparable_interface_init, /* interface_init */
+    NULL,                                            /* interface_finalize */
+    NULL                                             /* interface_data */
+  };
+  GType type = g_type_register_static (T_TYPE_NUMBER, "TInt", &info, 0);
+  g_type_add_interface_static (type, T_TYPE_COMPARABLE, &comparable_info);
+  return type;
+}
+
 GType
 t_int_get_type (void)
 {
-  static GType type = 0;
-  if (type == 0)
-    {
-      const GTypeInfo info = {
-        sizeof (TIntClass),
-        NULL,                                            /* base_init */
-        NULL,                                            /* base_finalize */
-        (GClassInitFunc)t_int_class_init,                /* class_init */
-        NULL,                                            /* class_finalize */
-        NULL,                                            /* class_data */
-        sizeof (TInt),
-        0,                                               /* n_preallocs */
-        (GInstanceInitFunc)t_int_init,                   /* instance_init */
-        NULL                                             /* value table */
-      };
-      const GInterfaceInfo comparable_info = {
-        (GInterfaceInitFunc)t_comparable_interface_init, /* interface_init */
-        NULL,                                            /* interface_finalize */
-        NULL                                             /* interface_data */
-      };
-      type = g_type_register_static (T_TYPE_NUMBER, "TInt", &info, 0);
-      g_type_add_interface_static (type, T_TYPE_COMPARABLE, &comparable_info);
-    }
-  return type;
+  static gsize type = 0;
+
+  return t_type_register_once (&type, t_int_register_type);
 }
 
 static int
@@ -190,7 +195,7 @@ t_int_div (TNumber *self, TNumber *other)
       g_object_get (T_INT (other), "value", &i, NULL);
       if (i == 0)
         {
-          g_signal_emit_by_name (self, "div-by-zero");
+          t_number_div_by_zero (self);
           return NULL;
         }
       else
@@ -203,7 +208,7 @@ t_int_div (TNumber *self, TNumber *other)
       g_object_get (T_DOUBLE (other), "value", &d, NULL);
       if (d == 0)
         {
-          g_signal_emit_by_name (self, "div-by-zero");
+          t_number_div_by_zero (self);
           return NULL;
         }
       else
@@ -232,6 +237,13 @@ t_int_to_s (TNumber *self)
   return g_strdup_printf ("%d", i);
 }
 
+static void
+t_int_serialize (TNumber *self, TNumberRecord *record)
+{
+  record->tag   = T_NUMBER_TAG_INT;
+  record->value = T_INT (self)->value;
+}
+
 static void
 t_int_class_init (TIntClass *class)
 {
@@ -239,12 +251,13 @@ t_int_class_init (TIntClass *class)
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
   /* override virtual functions */
-  tnumber_class->add    = t_int_add;
-  tnumber_class->sub    = t_int_sub;
-  tnumber_class->mul    = t_int_mul;
-  tnumber_class->div    = t_int_div;
-  tnumber_class->uminus = t_int_uminus;
-  tnumber_class->to_s   = t_int_to_s;
+  tnumber_class->add       = t_int_add;
+  tnumber_class->sub       = t_int_sub;
+  tnumber_class->mul       = t_int_mul;
+  tnumber_class->div       = t_int_div;
+  tnumber_class->uminus    = t_int_uminus;
+  tnumber_class->to_s      = t_int_to_s;
+  tnumber_class->serialize = t_int_serialize;
 
   gobject_class->set_property = t_int_set_property;
   gobject_class->get_property = t_int_get_property;
@@ -0,0 +1,63 @@
+/* benchmark: g_object_get vs the inline accessors of tnumberinline.h, t_number_add vs the typed functions */
+
+#include "tnumberinline.h"
+#include "tnumberops.h"
+#include <glib-object.h>
+
+#define N_CALLS 10000000
+
+static void
+report (const char *name, gint64 start, double sum)
+{
+  double usec = (double)(g_get_monotonic_time () - start);
+  g_print ("%-20s %10.3f ms %8.2f ns/call  (sum %f)\n", name, usec / 1000.0, usec * 1000.0 / N_CALLS, sum);
+}
+
+int
+main (void)
+{
+  TInt    *i_num = t_int_new_with_value (3);
+  TDouble *d_num = t_double_new_with_value (0.5);
+  TNumber *sum;
+  double   s, d;
+  gint64   start;
+  int      i, v;
+
+  start = g_get_monotonic_time ();
+  for (s = 0.0, i = 0; i < N_CALLS; ++i)
+    {
+      g_object_get (i_num, "value", &v, NULL);
+      g_object_get (d_num, "value", &d, NULL);
+      s += v + d;
+    }
+  report ("g_object_get", start, s);
+
+  start = g_get_monotonic_time ();
+  for (s = 0.0, i = 0; i < N_CALLS; ++i)
+    {
+      s += t_int_get_value (i_num) + t_double_get_value (d_num);
+    }
+  report ("inline getters", start, s);
+
+  start = g_get_monotonic_time ();
+  for (s = 0.0, i = 0; i < N_CALLS; ++i)
+    {
+      sum = t_number_add (T_NUMBER (d_num), T_NUMBER (i_num));
+      s += t_double_get_value (T_DOUBLE (sum));
+      g_object_unref (sum);
+    }
+  report ("t_number_add", start, s);
+
+  start = g_get_monotonic_time ();
+  for (s = 0.0, i = 0; i < N_CALLS; ++i)
+    {
+      TDouble *t = t_double_add_int (d_num, i_num);
+      s += t_double_get_value (t);
+      g_object_unref (t);
+    }
+  report ("t_double_add_int", start, s);
+
+  g_object_unref (i_num);
+  g_object_unref (d_num);
+  return 0;
+}
@@ -0,0 +1,69 @@
+/* benchmark: evaluating (a + b) * c - d / e with unref of each intermediate vs in an arena scope */
+
+#include "tdouble.h"
+#include "tint.h"
+#include "tnumberarena.h"
+#include "tnumberinline.h"
+#include <glib-object.h>
+
+#define N_EVALS 2000000
+
+static void
+report (const char *name, gint64 start, double sum)
+{
+  double usec = (double)(g_get_monotonic_time () - start);
+  g_print ("%-12s %10.3f ms %8.2f ns/eval  (sum %f)\n", name, usec / 1000.0, usec * 1000.0 / N_EVALS, sum);
+}
+
+int
+main (void)
+{
+  TNumber *a = T_NUMBER (t_double_new_with_value (1.5));
+  TNumber *b = T_NUMBER (t_int_new_with_value (2));
+  TNumber *c = T_NUMBER (t_double_new_with_value (3.0));
+  TNumber *d = T_NUMBER (t_int_new_with_value (10));
+  TNumber *e = T_NUMBER (t_double_new_with_value (4.0));
+  TNumber *t1, *t2, *t3, *r;
+  double   s;
+  gint64   start;
+  int      i;
+
+  start = g_get_monotonic_time ();
+  for (s = 0.0, i = 0; i < N_EVALS; ++i)
+    {
+      t1 = t_number_add (a, b);
+      t2 = t_number_mul (t1, c);
+      t3 = t_number_div (d, e);
+      r  = t_number_sub (t2, t3);
+      s += t_number_get_double (r);
+      g_object_unref (t1);
+      g_object_unref (t2);
+      g_object_unref (t3);
+      g_object_unref (r);
+    }
+  report ("unref", start, s);
+
+  start = g_get_monotonic_time ();
+  for (s = 0.0, i = 0; i < N_EVALS; ++i)
+    {
+      t_number_arena_push ();
+      r = t_number_sub (t_number_mul (t_number_add (a, b), c), t_number_div (d, e));
+      s += t_number_get_double (r);
+      t_number_arena_pop ();
+    }
+  report ("arena", start, s);
+
+  /* the result kept after the scope */
+  t_number_arena_push ();
+  r = t_number_arena_escape (t_number_sub (t_number_mul (t_number_add (a, b), c), t_number_div (d, e)));
+  t_number_arena_pop ();
+  g_print ("escaped      %f\n", t_number_get_double (r));
+  g_object_unref (r);
+
+  g_object_unref (a);
+  g_object_unref (b);
+  g_object_unref (c);
+  g_object_unref (d);
+  g_object_unref (e);
+  return 0;
+}
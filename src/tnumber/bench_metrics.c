@@ -0,0 +1,52 @@
+/* benchmark: t_number_add with the metrics off, on without timing, and on with timing (every call, every 64th) */
+
+#include "tdouble.h"
+#include "tint.h"
+#include "tmetrics.h"
+#include <glib-object.h>
+
+#define N_CALLS 10000000
+
+static void
+run (const char *name)
+{
+  TNumber *i_num = T_NUMBER (t_int_new_with_value (3));
+  TNumber *d_num = T_NUMBER (t_double_new_with_value (0.5));
+  TNumber *sum;
+  gint64   start = g_get_monotonic_time ();
+  double   usec;
+  int      i;
+
+  for (i = 0; i < N_CALLS; ++i)
+    {
+      sum = t_number_add (d_num, i_num);
+      g_object_unref (sum);
+    }
+  usec = (double)(g_get_monotonic_time () - start);
+  g_print ("%-24s %10.3f ms %8.2f ns/call\n", name, usec / 1000.0, usec * 1000.0 / N_CALLS);
+  g_object_unref (i_num);
+  g_object_unref (d_num);
+}
+
+int
+main (void)
+{
+  GVariant *snapshot;
+  char     *s;
+
+  run ("metrics off");
+  t_metrics_enable (0);
+  run ("counting only");
+  t_metrics_enable (64);
+  run ("timing 1 in 64");
+  t_metrics_enable (1);
+  run ("timing every call");
+  t_metrics_disable ();
+
+  snapshot = g_variant_ref_sink (t_metrics_snapshot ());
+  s        = g_variant_print (snapshot, FALSE);
+  g_print ("%s\n", s);
+  g_free (s);
+  g_variant_unref (snapshot);
+  return 0;
+}
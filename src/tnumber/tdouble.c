@@ -1,20 +1,24 @@
 #include "tdouble.h"
 #include "tint.h"
+#include "tnumberarena.h"
+#include "tnumberinline.h"
+#include "tnumberops.h"
 
 // ------------ TDouble --------------------------------------------------------------------------------------------- //
 
-struct _TDouble
-{
-  TNumber parent;
-  double  value;
-};
-
 G_DEFINE_TYPE (TDouble, t_double, T_TYPE_NUMBER)
 
 TDouble *
 t_double_new_with_value (double value)
 {
-  TDouble *d = g_object_new (T_TYPE_DOUBLE, "value", value, NULL);
+  TDouble *d;
+
+  if (T_NUMBER_ARENA_ACTIVE () && (d = t_number_arena_take (T_TYPE_DOUBLE)) != NULL)
+    {
+      d->value = value;
+      return d;
+    }
+  d = g_object_new (T_TYPE_DOUBLE, "value", value, NULL);
   return d;
 }
 
@@ -25,65 +29,21 @@ t_double_new (void)
   return d;
 }
 
-#define T_DOUBLE_BINARY_OP(op)                                                                                         \
-  if (T_IS_INT (other))                                                                                                \
-    {                                                                                                                  \
-      int i;                                                                                                           \
-      g_object_get (T_INT (other), "value", &i, NULL);                                                                 \
-      return T_NUMBER (t_double_new_with_value (T_DOUBLE (self)->value op (double) i));                                \
-    }                                                                                                                  \
-  else                                                                                                                 \
-    {                                                                                                                  \
-      double d;                                                                                                        \
-      g_object_get (T_DOUBLE (other), "value", &d, NULL);                                                              \
-      return T_NUMBER (t_double_new_with_value (T_DOUBLE (self)->value op d));                                         \
-    }
-
 #define T_DOUBLE_OP(op_name, op)                                                                                       \
   static TNumber *t_double_##op_name (TNumber *self, TNumber *other)                                                   \
   {                                                                                                                    \
     g_return_val_if_fail (T_IS_DOUBLE (self), NULL);                                                                   \
-    T_DOUBLE_BINARY_OP (+)                                                                                             \
+    if (T_IS_INT (other))                                                                                              \
+      {                                                                                                                \
+        return T_NUMBER (t_double_##op_name##_int (T_DOUBLE (self), T_INT (other)));                                   \
+      }                                                                                                                \
+    else                                                                                                               \
+      {                                                                                                                \
+        return T_NUMBER (t_double_##op_name##_double (T_DOUBLE (self), T_DOUBLE (other)));                             \
+      }                                                                                                                \
   }
 
-T_DOUBLE_OP (add, +)
-T_DOUBLE_OP (mul, *)
-T_DOUBLE_OP (sub, -)
-
-static TNumber *
-t_double_div (TNumber *self, TNumber *other)
-{
-  g_return_val_if_fail (T_IS_DOUBLE (self), NULL);
-
-  if (T_IS_INT (other))
-    {
-      int i;
-      g_object_get (T_INT (other), "value", &i, NULL);
-      if (i == 0)
-        {
-          g_signal_emit_by_name (self, "div-by-zero");
-          return NULL;
-        }
-      else
-        {
-          return T_NUMBER (t_double_new_with_value (T_DOUBLE (self)->value / (double)i));
-        }
-    }
-  else
-    {
-      double d;
-      g_object_get (T_DOUBLE (other), "value", &d, NULL);
-      if (d == 0)
-        {
-          g_signal_emit_by_name (self, "div-by-zero");
-          return NULL;
-        }
-      else
-        {
-          return T_NUMBER (t_double_new_with_value (T_DOUBLE (self)->value / d));
-        }
-    }
-}
+T_NUMBER_ARITH_OPS (T_DOUBLE_OP)
 
 static TNumber *
 t_double_uminus (TNumber *self)
@@ -97,10 +57,17 @@ t_double_to_s (TNumber *self)
 {
   g_return_val_if_fail (T_IS_DOUBLE (self), NULL);
   double d;
-  g_object_get (T_DOUBLE (self), "value", &d, NULL);
+  d = t_double_get_value (T_DOUBLE (self));
   return g_strdup_printf ("%f", d);
 }
 
+static void
+t_double_serialize (TNumber *self, TNumberRecord *record)
+{
+  record->tag   = T_NUMBER_TAG_DOUBLE;
+  record->value = T_DOUBLE (self)->value;
+}
+
 // ------------ Internals ------------------------------------------------------------------------------------------- //
 
 #define PROP_DOUBLE_ID 1
@@ -146,6 +113,7 @@ t_double_class_init (TDoubleClass *class)
   tnumber_class->div          = t_double_div;
   tnumber_class->uminus       = t_double_uminus;
   tnumber_class->to_s         = t_double_to_s;
+  tnumber_class->serialize    = t_double_serialize;
 
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
   gobject_class->set_property = t_double_set_property;
@@ -0,0 +1,233 @@
+/* stress test for the error channel of tnumbererror.c: emissions from several threads while other threads connect
+ * and disconnect handlers, and the forwarding to the "div-by-zero" signal */
+/* Build it also with -Db_sanitize=address or thread, which report the snapshots freed while an emission reads them. */
+
+#include "tint.h"
+#include "tnumbererror.h"
+#include <glib-object.h>
+
+#define N_EMITTERS   4
+#define N_CONNECTORS 4
+#define N_SLOTS      4 /* handlers per connector */
+#define N_ROUNDS     4000
+
+/* One per connection, so that a call can be told from a call of an earlier connection of the same slot.
+ * The records are freed at the end, a late call after disconnect would still find its record. */
+typedef struct
+{
+  gint disconnected;          /* set after t_number_error_disconnect has returned */
+  gint n_calls[N_EMITTERS];   /* written by the emitter thread only */
+} Connection;
+
+typedef struct
+{
+  Connection *current;        /* set after connecting, cleared before disconnecting */
+  guint       id;
+} Slot;
+
+static TNumber   *numbers[N_EMITTERS];
+static Slot       slots[N_CONNECTORS][N_SLOTS];
+static Connection connections[N_CONNECTORS][N_ROUNDS];
+static gint       n_connectors_running;
+static gint       n_failed;
+
+static void
+report (const char *message)
+{
+  if (g_atomic_int_add (&n_failed, 1) < 20)
+    {
+      g_print ("%s.\n", message);
+    }
+}
+
+// ------------ Emitters and connectors ----------------------------------------------------------------------------- //
+
+static void
+handler (TNumber *number, TNumberError error, gpointer user_data)
+{
+  Connection *c = user_data;
+  int         e;
+
+  if (g_atomic_int_get (&c->disconnected))
+    {
+      report ("A handler is called after t_number_error_disconnect has returned");
+    }
+  for (e = 0; e < N_EMITTERS; ++e)
+    {
+      if (numbers[e] == number)
+        {
+          g_atomic_int_inc (&c->n_calls[e]);
+        }
+    }
+}
+
+/* A connection which is current before the emission and still current after it was connected before the emission
+ * and not yet disconnected, so its handler must be called exactly once. */
+static gpointer
+emitter (gpointer data)
+{
+  int         e = GPOINTER_TO_INT (data);
+  Connection *before[N_CONNECTORS][N_SLOTS];
+  int         n_calls[N_CONNECTORS][N_SLOTS];
+  int         i, j;
+
+  while (g_atomic_int_get (&n_connectors_running) > 0)
+    {
+      for (i = 0; i < N_CONNECTORS; ++i)
+        {
+          for (j = 0; j < N_SLOTS; ++j)
+            {
+              before[i][j]  = g_atomic_pointer_get (&slots[i][j].current);
+              n_calls[i][j] = before[i][j] ? g_atomic_int_get (&before[i][j]->n_calls[e]) : 0;
+            }
+        }
+      t_number_error_emit (numbers[e], T_NUMBER_ERROR_DIV_BY_ZERO);
+      for (i = 0; i < N_CONNECTORS; ++i)
+        {
+          for (j = 0; j < N_SLOTS; ++j)
+            {
+              if (before[i][j] && before[i][j] == g_atomic_pointer_get (&slots[i][j].current)
+                  && g_atomic_int_get (&before[i][j]->n_calls[e]) != n_calls[i][j] + 1)
+                {
+                  report ("A handler connected before the emission isn't called once");
+                }
+            }
+        }
+    }
+  return NULL;
+}
+
+static void
+disconnect_slot (Slot *slot)
+{
+  Connection *c = slot->current;
+
+  g_atomic_pointer_set (&slot->current, NULL);
+  t_number_error_disconnect (slot->id);
+  g_atomic_int_set (&c->disconnected, TRUE);
+}
+
+/* connects and disconnects the handlers of its slots in turn */
+static gpointer
+connector (gpointer data)
+{
+  int   i = GPOINTER_TO_INT (data);
+  Slot *slot;
+  int   r;
+
+  for (r = 0; r < N_ROUNDS; ++r)
+    {
+      slot = &slots[i][r % N_SLOTS];
+      if (slot->current)
+        {
+          disconnect_slot (slot);
+        }
+      else
+        {
+          slot->id = t_number_error_connect (handler, &connections[i][r]);
+          g_atomic_pointer_set (&slot->current, &connections[i][r]);
+        }
+    }
+  for (r = 0; r < N_SLOTS; ++r)
+    {
+      if (slots[i][r].current)
+        {
+          disconnect_slot (&slots[i][r]);
+        }
+    }
+  g_atomic_int_add (&n_connectors_running, -1);
+  return NULL;
+}
+
+static void
+check_threads (void)
+{
+  GThread *emitters[N_EMITTERS], *connectors[N_CONNECTORS];
+  int      i;
+
+  for (i = 0; i < N_EMITTERS; ++i)
+    {
+      numbers[i] = T_NUMBER (t_int_new_with_value (i));
+    }
+  g_atomic_int_set (&n_connectors_running, N_CONNECTORS);
+  for (i = 0; i < N_CONNECTORS; ++i)
+    {
+      connectors[i] = g_thread_new ("connector", connector, GINT_TO_POINTER (i));
+    }
+  for (i = 0; i < N_EMITTERS; ++i)
+    {
+      emitters[i] = g_thread_new ("emitter", emitter, GINT_TO_POINTER (i));
+    }
+  for (i = 0; i < N_CONNECTORS; ++i)
+    {
+      g_thread_join (connectors[i]);
+    }
+  for (i = 0; i < N_EMITTERS; ++i)
+    {
+      g_thread_join (emitters[i]);
+      g_object_unref (numbers[i]);
+    }
+}
+
+// ------------ Forwarding to the signal ---------------------------------------------------------------------------- //
+
+static void
+count_cb (TNumber *number, TNumberError error, gpointer user_data)
+{
+  ++*(int *)user_data;
+}
+
+static void
+div_by_zero_cb (TNumber *number, gpointer user_data)
+{
+  ++*(int *)user_data;
+  /* the default handler only prints the error */
+  g_signal_stop_emission_by_name (number, "div-by-zero");
+}
+
+static void
+check_forward (void)
+{
+  TNumber *number = T_NUMBER (t_int_new_with_value (1));
+  int      n_channel = 0, n_signal = 0;
+  guint    id;
+
+  id = t_number_error_connect (count_cb, &n_channel);
+  g_signal_connect (number, "div-by-zero", G_CALLBACK (div_by_zero_cb), &n_signal);
+  t_number_div_by_zero (number);
+  if (n_channel != 1 || n_signal != 1)
+    {
+      report ("The error isn't reported to both the channel and the \"div-by-zero\" signal");
+    }
+  t_number_error_set_forward_signal (FALSE);
+  t_number_div_by_zero (number);
+  if (n_channel != 2 || n_signal != 1)
+    {
+      report ("The error is forwarded to the signal though forwarding is turned off");
+    }
+  t_number_error_set_forward_signal (TRUE);
+  t_number_div_by_zero (number);
+  if (n_channel != 3 || n_signal != 2)
+    {
+      report ("The error isn't forwarded to the signal after forwarding is turned on again");
+    }
+  t_number_error_disconnect (id);
+  t_number_div_by_zero (number);
+  if (n_channel != 3 || n_signal != 3)
+    {
+      report ("The disconnected handler is called, or the signal isn't emitted without a handler");
+    }
+  g_object_unref (number);
+}
+
+int
+main (void)
+{
+  check_forward ();
+  check_threads ();
+  if (n_failed)
+    {
+      g_print ("%d failures\n", n_failed);
+    }
+  return n_failed ? 1 : 0;
+}
@@ -1,20 +1,24 @@
-#include "tint.h"
 #include "tdouble.h"
+#include "tint.h"
+#include "tnumberarena.h"
+#include "tnumberinline.h"
+#include "tnumberops.h"
 
 // ------------ TInt ------------------------------------------------------------------------------------------------ //
 
-struct _TInt
-{
-  TNumber parent;
-  int     value;
-};
-
 G_DEFINE_TYPE (TInt, t_int, T_TYPE_NUMBER)
 
 TInt *
 t_int_new_with_value (int value)
 {
-  TInt *i = g_object_new (T_TYPE_INT, "value", value, NULL);
+  TInt *i;
+
+  if (T_NUMBER_ARENA_ACTIVE () && (i = t_number_arena_take (T_TYPE_INT)) != NULL)
+    {
+      i->value = value;
+      return i;
+    }
+  i = g_object_new (T_TYPE_INT, "value", value, NULL);
   return i;
 }
 
@@ -25,65 +29,21 @@ t_int_new (void)
   return i;
 }
 
-#define T_INT_BINARY_OP(op)                                                                                            \
-  int    i;                                                                                                            \
-  double d;                                                                                                            \
-  if (T_IS_INT (other))                                                                                                \
-    {                                                                                                                  \
-      g_object_get (T_INT (other), "value", &i, NULL);                                                                 \
-      return T_NUMBER (t_int_new_with_value (T_INT (self)->value op i));                                               \
-    }                                                                                                                  \
-  else                                                                                                                 \
-    {                                                                                                                  \
-      g_object_get (T_DOUBLE (other), "value", &d, NULL);                                                              \
-      return T_NUMBER (t_int_new_with_value (T_INT (self)->value op (int) d));                                         \
-    }
-
 #define T_INT_OP(op_name, op)                                                                                          \
   static TNumber *t_int_##op_name (TNumber *self, TNumber *other)                                                      \
   {                                                                                                                    \
     g_return_val_if_fail (T_IS_INT (self), NULL);                                                                      \
-    T_INT_BINARY_OP (+)                                                                                                \
+    if (T_IS_INT (other))                                                                                              \
+      {                                                                                                                \
+        return T_NUMBER (t_int_##op_name##_int (T_INT (self), T_INT (other)));                                         \
+      }                                                                                                                \
+    else                                                                                                               \
+      {                                                                                                                \
+        return T_NUMBER (t_int_##op_name##_double (T_INT (self), T_DOUBLE (other)));                                   \
+      }                                                                                                                \
   }
 
-T_INT_OP (add, +)
-T_INT_OP (mul, *)
-T_INT_OP (sub, -)
-
-static TNumber *
-t_int_div (TNumber *self, TNumber *other)
-{
-  g_return_val_if_fail (T_IS_INT (self), NULL);
-
-  if (T_IS_INT (other))
-    {
-      int i;
-      g_object_get (T_INT (other), "value", &i, NULL);
-      if (i == 0)
-        {
-          g_signal_emit_by_name (self, "div-by-zero");
-          return NULL;
-        }
-      else
-        {
-          return T_NUMBER (t_int_new_with_value (T_INT (self)->value / i));
-        }
-    }
-  else
-    {
-      double d;
-      g_object_get (T_DOUBLE (other), "value", &d, NULL);
-      if (d == 0)
-        {
-          g_signal_emit_by_name (self, "div-by-zero");
-          return NULL;
-        }
-      else
-        {
-          return T_NUMBER (t_int_new_with_value (T_INT (self)->value / (int)d));
-        }
-    }
-}
+T_NUMBER_ARITH_OPS (T_INT_OP)
 
 static TNumber *
 t_int_uminus (TNumber *self)
@@ -97,10 +57,17 @@ t_int_to_s (TNumber *self)
 {
   g_return_val_if_fail (T_IS_INT (self), NULL);
   int i;
-  g_object_get (T_INT (self), "value", &i, NULL);
+  i = t_int_get_value (T_INT (self));
   return g_strdup_printf ("%d", i);
 }
 
+static void
+t_int_serialize (TNumber *self, TNumberRecord *record)
+{
+  record->tag   = T_NUMBER_TAG_INT;
+  record->value = T_INT (self)->value;
+}
+
 // ------------ Internals ------------------------------------------------------------------------------------------- //
 
 #define PROP_INT_ID 1
@@ -146,6 +113,7 @@ t_int_class_init (TIntClass *class)
   tnumber_class->div          = t_int_div;
   tnumber_class->uminus       = t_int_uminus;
   tnumber_class->to_s         = t_int_to_s;
+  tnumber_class->serialize    = t_int_serialize;
 
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
   gobject_class->set_property = t_int_set_property;
@@ -0,0 +1,277 @@
+#include "tmetrics.h"
+#include <string.h>
+#include <time.h>
+
+// Each thread writes only its own block, without atomics or locks. The list of the blocks is changed under the lock
+// when a thread makes its first instrumented call and when it exits; then its counts are added to retired.
+// A snapshot adds up retired and the live blocks under the lock. It reads the live blocks while their threads may
+// write them, so it can miss the last few calls, but no count is read torn on a 64-bit target.
+// Reset doesn't touch the blocks of other threads. It saves the current totals, which snapshots subtract.
+
+#define T_METRICS_SUB_BITS 2
+#define T_METRICS_SUB      (1 << T_METRICS_SUB_BITS)
+#define T_METRICS_MAX_EXP  40 /* durations from 2^40 ns (18 minutes) on go to the last bucket */
+#define T_METRICS_BUCKETS  ((T_METRICS_MAX_EXP - T_METRICS_SUB_BITS + 2) * T_METRICS_SUB)
+
+typedef struct
+{
+  guint64 calls;
+  guint64 timed;
+  guint64 sum_ns;
+  guint64 buckets[T_METRICS_BUCKETS];
+} TMetricsCounter;
+
+typedef struct
+{
+  TMetricsCounter counters[T_METRIC_N];
+  gint            countdown[T_METRIC_N]; /* calls until the next timed one */
+} TMetricsThread;
+
+static void t_metrics_thread_free (gpointer data);
+
+gint t_metrics_enabled = FALSE;
+
+static const char *const metric_names[T_METRIC_N] = {
+  "number.add", "number.sub", "number.mul", "number.div", "str.concat", "comparable.cmp",
+};
+
+static GMutex          metrics_lock;
+static GPtrArray      *threads = NULL; /* live TMetricsThread */
+static TMetricsCounter retired[T_METRIC_N];
+static TMetricsCounter baseline[T_METRIC_N];
+static gint            sample_interval;
+static GPrivate        thread_key = G_PRIVATE_INIT (t_metrics_thread_free);
+
+// ------------ Histogram ------------------------------------------------------------------------------------------- //
+
+// Values below T_METRICS_SUB have a bucket each. Above, each power of two is split into T_METRICS_SUB buckets.
+static inline guint
+t_metrics_bucket (guint64 ns)
+{
+  int   exp;
+  guint sub;
+
+  if (ns < T_METRICS_SUB)
+    {
+      return (guint)ns;
+    }
+  exp = 63 - __builtin_clzll (ns);
+  if (exp > T_METRICS_MAX_EXP)
+    {
+      return T_METRICS_BUCKETS - 1;
+    }
+  sub = (guint)(ns >> (exp - T_METRICS_SUB_BITS)) & (T_METRICS_SUB - 1);
+  return (exp - T_METRICS_SUB_BITS + 1) * T_METRICS_SUB + sub;
+}
+
+static guint64
+t_metrics_bucket_lower_bound (guint bucket)
+{
+  guint exp = bucket / T_METRICS_SUB + T_METRICS_SUB_BITS - 1;
+
+  if (bucket < T_METRICS_SUB)
+    {
+      return bucket;
+    }
+  return (guint64)(T_METRICS_SUB + bucket % T_METRICS_SUB) << (exp - T_METRICS_SUB_BITS);
+}
+
+static void
+t_metrics_counter_add (TMetricsCounter *to, const TMetricsCounter *from)
+{
+  guint i;
+
+  to->calls += from->calls;
+  to->timed += from->timed;
+  to->sum_ns += from->sum_ns;
+  for (i = 0; i < T_METRICS_BUCKETS; ++i)
+    {
+      to->buckets[i] += from->buckets[i];
+    }
+}
+
+static void
+t_metrics_counter_sub (TMetricsCounter *to, const TMetricsCounter *from)
+{
+  guint i;
+
+  to->calls -= from->calls;
+  to->timed -= from->timed;
+  to->sum_ns -= from->sum_ns;
+  for (i = 0; i < T_METRICS_BUCKETS; ++i)
+    {
+      to->buckets[i] -= from->buckets[i];
+    }
+}
+
+// ------------ Per-thread blocks ----------------------------------------------------------------------------------- //
+
+static void
+t_metrics_thread_free (gpointer data)
+{
+  TMetricsThread *block = data;
+  int             m;
+
+  g_mutex_lock (&metrics_lock);
+  for (m = 0; m < T_METRIC_N; ++m)
+    {
+      t_metrics_counter_add (&retired[m], &block->counters[m]);
+    }
+  g_ptr_array_remove_fast (threads, block);
+  g_mutex_unlock (&metrics_lock);
+  g_free (block);
+}
+
+static TMetricsThread *
+t_metrics_thread (void)
+{
+  TMetricsThread *block = g_private_get (&thread_key);
+  int             m;
+
+  if (G_UNLIKELY (block == NULL))
+    {
+      block = g_new0 (TMetricsThread, 1);
+      for (m = 0; m < T_METRIC_N; ++m)
+        {
+          block->countdown[m] = 1; /* the first call is timed */
+        }
+      g_mutex_lock (&metrics_lock);
+      if (threads == NULL)
+        {
+          threads = g_ptr_array_new ();
+        }
+      g_ptr_array_add (threads, block);
+      g_mutex_unlock (&metrics_lock);
+      g_private_set (&thread_key, block);
+    }
+  return block;
+}
+
+static inline gint64
+t_metrics_now (void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+  return g_get_monotonic_time () * 1000;
+#endif
+}
+
+// Counts the call. Returns the time in ns if the call is timed, otherwise 0.
+gint64
+t_metrics_begin (TMetric metric)
+{
+  TMetricsThread *block = t_metrics_thread ();
+  gint            interval;
+
+  ++block->counters[metric].calls;
+  if (G_LIKELY (--block->countdown[metric] > 0))
+    {
+      return 0;
+    }
+  interval                 = g_atomic_int_get (&sample_interval);
+  block->countdown[metric] = interval > 0 ? interval : G_MAXINT;
+  return interval > 0 ? t_metrics_now () : 0;
+}
+
+void
+t_metrics_end (TMetric metric, gint64 start)
+{
+  TMetricsCounter *counter = &t_metrics_thread ()->counters[metric];
+  guint64          ns      = (guint64)MAX (t_metrics_now () - start, 0);
+
+  ++counter->timed;
+  counter->sum_ns += ns;
+  ++counter->buckets[t_metrics_bucket (ns)];
+}
+
+// ------------ Control --------------------------------------------------------------------------------------------- //
+
+// Turns the metrics on. Every sample_interval-th call of each thread is timed; 0 times none, 1 times every call.
+// If they are already on, only the interval is changed.
+void
+t_metrics_enable (guint interval)
+{
+  g_atomic_int_set (&sample_interval, (gint)MIN (interval, G_MAXINT));
+  g_atomic_int_set (&t_metrics_enabled, TRUE);
+}
+
+// Turns the metrics off. The counts are kept.
+void
+t_metrics_disable (void)
+{
+  g_atomic_int_set (&t_metrics_enabled, FALSE);
+}
+
+static void
+t_metrics_sum (TMetricsCounter *sum)
+{
+  guint i;
+  int   m;
+
+  memcpy (sum, retired, sizeof retired);
+  for (i = 0; threads && i < threads->len; ++i)
+    {
+      TMetricsThread *block = g_ptr_array_index (threads, i);
+
+      for (m = 0; m < T_METRIC_N; ++m)
+        {
+          t_metrics_counter_add (&sum[m], &block->counters[m]);
+        }
+    }
+}
+
+// Starts the counts of the following snapshots from zero.
+void
+t_metrics_reset (void)
+{
+  g_mutex_lock (&metrics_lock);
+  t_metrics_sum (baseline);
+  g_mutex_unlock (&metrics_lock);
+}
+
+const char *
+t_metrics_get_name (TMetric metric)
+{
+  g_return_val_if_fail ((guint)metric < T_METRIC_N, NULL);
+  return metric_names[metric];
+}
+
+// Returns a floating GVariant of type T_METRICS_SNAPSHOT_TYPE.
+GVariant *
+t_metrics_snapshot (void)
+{
+  TMetricsCounter *sum = g_new (TMetricsCounter, T_METRIC_N);
+  GVariantBuilder  builder, buckets;
+  guint64          n;
+  guint            i;
+  int              m;
+
+  g_mutex_lock (&metrics_lock);
+  t_metrics_sum (sum);
+  for (m = 0; m < T_METRIC_N; ++m)
+    {
+      t_metrics_counter_sub (&sum[m], &baseline[m]);
+    }
+  g_mutex_unlock (&metrics_lock);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE (T_METRICS_SNAPSHOT_TYPE));
+  for (m = 0; m < T_METRIC_N; ++m)
+    {
+      g_variant_builder_init (&buckets, G_VARIANT_TYPE ("a(tt)"));
+      for (i = 0; i < T_METRICS_BUCKETS; ++i)
+        {
+          if ((n = sum[m].buckets[i]) > 0)
+            {
+              g_variant_builder_add (&buckets, "(tt)", t_metrics_bucket_lower_bound (i), n);
+            }
+        }
+      g_variant_builder_add (&builder, "{s(ttta(tt))}", metric_names[m], sum[m].calls, sum[m].timed, sum[m].sum_ns,
+                             &buckets);
+    }
+  g_free (sum);
+  return g_variant_builder_end (&builder);
+}
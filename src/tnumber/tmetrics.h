@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glib-object.h>
+
+// Call counters and latency histograms of the numeric core, for an exporter to scrape with t_metrics_snapshot.
+// They are off by default, and then an instrumented call costs one atomic load. When on, every call is counted in
+// a block owned by the calling thread, and every sample_interval-th call of a thread is timed into a log-linear
+// (HDR-style) histogram with 4 buckets per power of two. The blocks are merged only when a snapshot is taken.
+// Define T_DISABLE_METRICS (meson option metrics=false) to compile the instrumentation out.
+
+typedef enum
+{
+  T_METRIC_NUMBER_ADD,
+  T_METRIC_NUMBER_SUB,
+  T_METRIC_NUMBER_MUL,
+  T_METRIC_NUMBER_DIV,
+  T_METRIC_STR_CONCAT,
+  T_METRIC_COMPARABLE_CMP,
+  T_METRIC_N
+} TMetric;
+
+// name => (calls, timed calls, sum of the timed durations in ns, [(lower bound of the bucket in ns, timed calls)])
+// Only the buckets which aren't empty are listed.
+#define T_METRICS_SNAPSHOT_TYPE "a{s(ttta(tt))}"
+
+void        t_metrics_enable (guint sample_interval);
+void        t_metrics_disable (void);
+void        t_metrics_reset (void);
+GVariant   *t_metrics_snapshot (void);
+const char *t_metrics_get_name (TMetric metric);
+
+/* used by the macros below */
+extern gint t_metrics_enabled;
+gint64      t_metrics_begin (TMetric metric);
+void        t_metrics_end (TMetric metric, gint64 start);
+
+// gint64 start = T_METRICS_BEGIN (metric); ... T_METRICS_END (metric, start);
+// start is 0 unless the call is timed.
+#ifdef T_DISABLE_METRICS
+#define T_METRICS_BEGIN(metric)      0
+#define T_METRICS_END(metric, start) ((void)(start))
+#else
+#define T_METRICS_BEGIN(metric)      (G_UNLIKELY (g_atomic_int_get (&t_metrics_enabled)) ? t_metrics_begin (metric) : 0)
+#define T_METRICS_END(metric, start) (G_UNLIKELY ((start) != 0) ? t_metrics_end (metric, start) : (void)0)
+#endif
@@ -1,4 +1,11 @@
 #include "tnumber.h"
+#include "tdouble.h"
+#include "tint.h"
+#include "tmetrics.h"
+#include "tnumberarena.h"
+#include "tnumbererror.h"
+#include "tprofile.h"
+#include "ttrace.h"
 
 static guint t_number_signal;
 
@@ -10,9 +17,34 @@ div_by_zero_default_cb (TNumber *self)
   g_printerr ("Error: division by zero.\n");
 }
 
+static void
+t_number_constructed (GObject *object)
+{
+  if (T_PROFILE_ENABLED ())
+    {
+      t_profile_instance_new (object);
+    }
+  G_OBJECT_CLASS (t_number_parent_class)->constructed (object);
+}
+
+static void
+t_number_finalize (GObject *object)
+{
+  if (T_PROFILE_ENABLED ())
+    {
+      t_profile_instance_free (object);
+    }
+  G_OBJECT_CLASS (t_number_parent_class)->finalize (object);
+}
+
 static void
 t_number_class_init (TNumberClass *class)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+  gobject_class->constructed  = t_number_constructed;
+  gobject_class->finalize     = t_number_finalize;
+  t_profile_init_from_env ();
+
   /* virtual functions */
   class->add         = NULL;
   class->sub         = NULL;
@@ -20,6 +52,7 @@ t_number_class_init (TNumberClass *class)
   class->div         = NULL;
   class->uminus      = NULL;
   class->to_s        = NULL;
+  class->serialize   = NULL;
   class->div_by_zero = div_by_zero_default_cb;
 
   GSignalFlags signal_flags = G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS;
@@ -33,26 +66,167 @@ t_number_init (TNumber *self)
 {
 }
 
-#define T_NUMBER_BIN_OP(op)                                                                                            \
+#define T_NUMBER_BIN_OP(op, metric)                                                                                    \
   TNumber *t_number_##op (TNumber *self, TNumber *other)                                                               \
   {                                                                                                                    \
     g_return_val_if_fail (T_IS_NUMBER (self), NULL);                                                                   \
     g_return_val_if_fail (T_IS_NUMBER (other), NULL);                                                                  \
     TNumberClass *class = T_NUMBER_GET_CLASS (self);                                                                   \
-    return class->op ? class->op (self, other) : NULL;                                                                 \
+    TNumber      *result;                                                                                              \
+    gint64        start = T_METRICS_BEGIN (metric);                                                                    \
+    T_TRACE3 (number_op_entry, #op, self, other);                                                                      \
+    result = class->op ? T_NUMBER_ARENA_ADOPT (class->op (self, other)) : NULL;                                        \
+    T_TRACE2 (number_op_return, #op, result);                                                                          \
+    T_METRICS_END (metric, start);                                                                                     \
+    return result;                                                                                                     \
   }
 
-#define T_NUMBER_UNI_OP(op, type)                                                                                      \
+// adopt is T_NUMBER_ARENA_ADOPT for TNumber results and empty for the others
+#define T_NUMBER_UNI_OP(op, type, adopt)                                                                               \
   type *t_number_##op (TNumber *self)                                                                                  \
   {                                                                                                                    \
     g_return_val_if_fail (T_IS_NUMBER (self), NULL);                                                                   \
     TNumberClass *class = T_NUMBER_GET_CLASS (self);                                                                   \
-    return class->op ? class->op (self) : NULL;                                                                        \
+    type         *result;                                                                                              \
+    T_TRACE3 (number_op_entry, #op, self, NULL);                                                                       \
+    result = class->op ? adopt (class->op (self)) : NULL;                                                              \
+    T_TRACE2 (number_op_return, #op, result);                                                                          \
+    return result;                                                                                                     \
   }
 
-T_NUMBER_BIN_OP (add)
-T_NUMBER_BIN_OP (sub)
-T_NUMBER_BIN_OP (mul)
-T_NUMBER_BIN_OP (div)
-T_NUMBER_UNI_OP (uminus, TNumber)
-T_NUMBER_UNI_OP (to_s, char)
+T_NUMBER_BIN_OP (add, T_METRIC_NUMBER_ADD)
+T_NUMBER_BIN_OP (sub, T_METRIC_NUMBER_SUB)
+T_NUMBER_BIN_OP (mul, T_METRIC_NUMBER_MUL)
+T_NUMBER_BIN_OP (div, T_METRIC_NUMBER_DIV)
+T_NUMBER_UNI_OP (uminus, TNumber, T_NUMBER_ARENA_ADOPT)
+T_NUMBER_UNI_OP (to_s, char, )
+
+// Reports a division by zero to the handlers of the error channel (see tnumbererror.c),
+// then emits "div-by-zero" unless forwarding to the signal is turned off.
+void
+t_number_div_by_zero (TNumber *self)
+{
+  g_return_if_fail (T_IS_NUMBER (self));
+
+  T_TRACE1 (number_div_by_zero, self);
+  t_number_error_emit (self, T_NUMBER_ERROR_DIV_BY_ZERO);
+  if (t_number_error_get_forward_signal ())
+    {
+      g_signal_emit (self, t_number_signal, 0);
+    }
+}
+
+// ------------ Serialization --------------------------------------------------------------------------------------- //
+
+#define T_NUMBER_ARRAY_TYPE G_VARIANT_TYPE ("a(yd)")
+
+G_STATIC_ASSERT (sizeof (TNumberRecord) == 16);
+
+// Returns a floating GVariant of type "i" (TInt) or "d" (TDouble).
+GVariant *
+t_number_serialize (TNumber *self)
+{
+  g_return_val_if_fail (T_IS_NUMBER (self), NULL);
+
+  TNumberClass *class = T_NUMBER_GET_CLASS (self);
+  TNumberRecord record;
+
+  if (class->serialize == NULL)
+    {
+      return NULL;
+    }
+  class->serialize (self, &record);
+  if (record.tag == T_NUMBER_TAG_INT)
+    {
+      return g_variant_new_int32 ((gint32)record.value);
+    }
+  else
+    {
+      return g_variant_new_double (record.value);
+    }
+}
+
+TNumber *
+t_number_deserialize (GVariant *variant)
+{
+  g_return_val_if_fail (variant != NULL, NULL);
+
+  if (g_variant_is_of_type (variant, G_VARIANT_TYPE_INT32))
+    {
+      return T_NUMBER (t_int_new_with_value (g_variant_get_int32 (variant)));
+    }
+  else if (g_variant_is_of_type (variant, G_VARIANT_TYPE_DOUBLE))
+    {
+      return T_NUMBER (t_double_new_with_value (g_variant_get_double (variant)));
+    }
+  else
+    {
+      return NULL;
+    }
+}
+
+// Returns a floating GVariant of type "a(yd)".
+// The records are written into one buffer, which becomes the data of the GVariant without being copied.
+// The data is in host byte order. Use g_variant_byteswap on the receiver if the byte order differs.
+GVariant *
+t_number_serialize_array (TNumber **numbers, gsize n)
+{
+  g_return_val_if_fail (numbers != NULL || n == 0, NULL);
+
+  TNumberRecord *records;
+  gsize          i;
+
+  if (n == 0)
+    {
+      return g_variant_new_array (G_VARIANT_TYPE ("(yd)"), NULL, 0);
+    }
+  /* zero-filled, so that the padding after the tag is in normal form */
+  records = g_new0 (TNumberRecord, n);
+  for (i = 0; i < n; ++i)
+    {
+      TNumberClass *class = T_IS_NUMBER (numbers[i]) ? T_NUMBER_GET_CLASS (numbers[i]) : NULL;
+
+      if (class == NULL || class->serialize == NULL)
+        {
+          g_free (records);
+          g_return_val_if_reached (NULL);
+        }
+      class->serialize (numbers[i], &records[i]);
+    }
+  return g_variant_new_from_data (T_NUMBER_ARRAY_TYPE, records, n * sizeof (TNumberRecord), TRUE, g_free, records);
+}
+
+// Returns an array of new TNumber instances. The array owns the references.
+// Returns NULL for a record with an unknown tag, or an int tag whose value isn't an int (NaN, fraction, out of range).
+GPtrArray *
+t_number_deserialize_array (GVariant *variant)
+{
+  g_return_val_if_fail (variant != NULL, NULL);
+  g_return_val_if_fail (g_variant_is_of_type (variant, T_NUMBER_ARRAY_TYPE), NULL);
+
+  const TNumberRecord *records;
+  GPtrArray           *numbers;
+  gsize                n, i;
+
+  records = g_variant_get_fixed_array (variant, &n, sizeof (TNumberRecord));
+  numbers = g_ptr_array_new_full (n, g_object_unref);
+  for (i = 0; i < n; ++i)
+    {
+      double value = records[i].value;
+
+      if (records[i].tag == T_NUMBER_TAG_INT && G_MININT <= value && value <= G_MAXINT && value == (int)value)
+        {
+          g_ptr_array_add (numbers, t_int_new_with_value ((int)value));
+        }
+      else if (records[i].tag == T_NUMBER_TAG_DOUBLE)
+        {
+          g_ptr_array_add (numbers, t_double_new_with_value (value));
+        }
+      else
+        {
+          g_ptr_array_unref (numbers);
+          return NULL;
+        }
+    }
+  return numbers;
+}
@@ -6,6 +6,18 @@
 
 G_DECLARE_DERIVABLE_TYPE (TNumber, t_number, T, NUMBER, GObject)
 
+// tags of TNumberRecord, which are the GVariant types of the serialized values
+#define T_NUMBER_TAG_INT    'i'
+#define T_NUMBER_TAG_DOUBLE 'd'
+
+// This is the layout of the GVariant type "(yd)".
+// An array of TNumberRecord is the serialized data of the GVariant type "a(yd)".
+typedef struct
+{
+  guint8 tag;
+  double value;
+} TNumberRecord;
+
 struct _TNumberClass
 {
   GObjectClass parent_class;
@@ -15,6 +27,7 @@ struct _TNumberClass
   TNumber *(*div) (TNumber *self, TNumber *other);
   TNumber *(*uminus) (TNumber *self);
   char *(*to_s) (TNumber *self);
+  void (*serialize) (TNumber *self, TNumberRecord *record);
   void (*div_by_zero) (TNumber *self);
 };
 
@@ -24,3 +37,9 @@ TNumber *t_number_mul (TNumber *self, TNumber *other);
 TNumber *t_number_div (TNumber *self, TNumber *other);
 TNumber *t_number_uminus (TNumber *self);
 char    *t_number_to_s (TNumber *self);
+void     t_number_div_by_zero (TNumber *self);
+
+GVariant  *t_number_serialize (TNumber *self);
+TNumber   *t_number_deserialize (GVariant *variant);
+GVariant  *t_number_serialize_array (TNumber **numbers, gsize n);
+GPtrArray *t_number_deserialize_array (GVariant *variant);
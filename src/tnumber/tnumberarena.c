@@ -0,0 +1,169 @@
+#include "tnumberarena.h"
+#include "tdouble.h"
+#include "tint.h"
+
+// The results of all open scopes of a thread are in one stack. Each push saves the height of the stack, and pop
+// releases the results above the saved height. An escaped result leaves NULL in its slot.
+// t_number_arena_active counts the open scopes of all threads, so that the functions called by every t_number_*
+// cost one atomic load while no thread uses an arena.
+
+#define T_NUMBER_ARENA_POOL_MAX 1024 /* per type and thread */
+
+typedef struct
+{
+  GPtrArray *results; /* TNumber, or NULL where escaped */
+  GArray    *marks;   /* guint, results->len at each push */
+  GPtrArray *pools[2]; /* free TInt and TDouble */
+} TNumberArena;
+
+static void t_number_arena_free (gpointer data);
+
+gint t_number_arena_active = 0;
+
+static GPrivate arena_key = G_PRIVATE_INIT (t_number_arena_free);
+
+static void
+t_number_arena_release (TNumberArena *arena, guint height)
+{
+  GObject   *object;
+  GPtrArray *pool;
+  guint      i;
+
+  for (i = arena->results->len; i > height; --i)
+    {
+      if ((object = g_ptr_array_index (arena->results, i - 1)) == NULL)
+        {
+          continue;
+        }
+      pool = G_OBJECT_TYPE (object) == T_TYPE_INT      ? arena->pools[0]
+             : G_OBJECT_TYPE (object) == T_TYPE_DOUBLE ? arena->pools[1]
+                                                       : NULL;
+      /* the reference of the arena is the only one, so the instance can be reused */
+      if (pool && g_atomic_int_get ((gint *)&object->ref_count) == 1 && pool->len < T_NUMBER_ARENA_POOL_MAX)
+        {
+          g_ptr_array_add (pool, object);
+        }
+      else
+        {
+          g_object_unref (object);
+        }
+    }
+  g_ptr_array_set_size (arena->results, height);
+}
+
+static void
+t_number_arena_free (gpointer data)
+{
+  TNumberArena *arena = data;
+
+  if (arena->marks->len > 0)
+    {
+      g_atomic_int_add (&t_number_arena_active, -(gint)arena->marks->len);
+    }
+  t_number_arena_release (arena, 0);
+  g_ptr_array_unref (arena->results);
+  g_array_unref (arena->marks);
+  g_ptr_array_unref (arena->pools[0]);
+  g_ptr_array_unref (arena->pools[1]);
+  g_free (arena);
+}
+
+static TNumberArena *
+t_number_arena_get (void)
+{
+  TNumberArena *arena = g_private_get (&arena_key);
+
+  if (G_UNLIKELY (arena == NULL))
+    {
+      arena           = g_new (TNumberArena, 1);
+      arena->results  = g_ptr_array_new ();
+      arena->marks    = g_array_new (FALSE, FALSE, sizeof (guint));
+      arena->pools[0] = g_ptr_array_new_with_free_func (g_object_unref);
+      arena->pools[1] = g_ptr_array_new_with_free_func (g_object_unref);
+      g_private_set (&arena_key, arena);
+    }
+  return arena;
+}
+
+void
+t_number_arena_push (void)
+{
+  TNumberArena *arena = t_number_arena_get ();
+
+  g_array_append_val (arena->marks, arena->results->len);
+  g_atomic_int_inc (&t_number_arena_active);
+}
+
+// Releases the results of the innermost scope which aren't escaped.
+void
+t_number_arena_pop (void)
+{
+  TNumberArena *arena = g_private_get (&arena_key);
+  guint         height;
+
+  g_return_if_fail (arena != NULL && arena->marks->len > 0);
+
+  height = g_array_index (arena->marks, guint, arena->marks->len - 1);
+  g_array_set_size (arena->marks, arena->marks->len - 1);
+  t_number_arena_release (arena, height);
+  g_atomic_int_add (&t_number_arena_active, -1);
+}
+
+// Returns a reference to number owned by the caller. A result of the innermost scope is taken out of the arena,
+// anything else (a result of an outer scope, or any other number) is referenced.
+TNumber *
+t_number_arena_escape (TNumber *number)
+{
+  TNumberArena *arena = g_private_get (&arena_key);
+  guint         i, height;
+
+  g_return_val_if_fail (T_IS_NUMBER (number), NULL);
+
+  if (arena && arena->marks->len > 0)
+    {
+      height = g_array_index (arena->marks, guint, arena->marks->len - 1);
+      /* the result escaped is usually the last one */
+      for (i = arena->results->len; i > height; --i)
+        {
+          if (g_ptr_array_index (arena->results, i - 1) == number)
+            {
+              g_ptr_array_index (arena->results, i - 1) = NULL;
+              return number;
+            }
+        }
+    }
+  return g_object_ref (number);
+}
+
+// Hands number (a new reference) to the innermost scope, if the thread has one, and returns it.
+TNumber *
+t_number_arena_adopt (TNumber *number)
+{
+  TNumberArena *arena = g_private_get (&arena_key);
+
+  if (number && arena && arena->marks->len > 0)
+    {
+      g_ptr_array_add (arena->results, number);
+    }
+  return number;
+}
+
+// Returns a pooled instance of type (T_TYPE_INT or T_TYPE_DOUBLE) with the reference, or NULL if the thread has no
+// open scope or the pool is empty. The caller sets its value.
+gpointer
+t_number_arena_take (GType type)
+{
+  TNumberArena *arena = g_private_get (&arena_key);
+  GPtrArray    *pool;
+
+  if (arena == NULL || arena->marks->len == 0)
+    {
+      return NULL;
+    }
+  pool = type == T_TYPE_INT ? arena->pools[0] : type == T_TYPE_DOUBLE ? arena->pools[1] : NULL;
+  if (pool == NULL || pool->len == 0)
+    {
+      return NULL;
+    }
+  return g_ptr_array_steal_index_fast (pool, pool->len - 1);
+}
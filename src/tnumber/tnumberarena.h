@@ -0,0 +1,25 @@
+#pragma once
+
+#include "tnumber.h"
+#include <glib-object.h>
+
+// Scopes for the intermediates of an expression.
+// Between t_number_arena_push and t_number_arena_pop, the results of t_number_add, sub, mul, div and uminus belong
+// to the arena of the calling thread, so the caller doesn't unref them. Pop releases the results of the innermost
+// scope at once. The TInt and TDouble instances nobody else holds go to a per-thread pool, and inside a scope
+// t_int_new_with_value and t_double_new_with_value take instances from it instead of constructing new ones.
+// A result which must outlive the scope is taken out with t_number_arena_escape and is then an ordinary reference.
+// Don't connect signal handlers to results or set data on them unless they are escaped.
+
+extern gint t_number_arena_active;
+
+#define T_NUMBER_ARENA_ACTIVE()      G_UNLIKELY (g_atomic_int_get (&t_number_arena_active))
+#define T_NUMBER_ARENA_ADOPT(number) (T_NUMBER_ARENA_ACTIVE () ? t_number_arena_adopt (number) : (number))
+
+void     t_number_arena_push (void);
+void     t_number_arena_pop (void);
+TNumber *t_number_arena_escape (TNumber *number);
+
+/* called by t_number_* and the constructors */
+TNumber *t_number_arena_adopt (TNumber *number);
+gpointer t_number_arena_take (GType type);
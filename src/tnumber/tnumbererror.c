@@ -0,0 +1,206 @@
+#include "tnumbererror.h"
+#include <string.h>
+
+// A notification channel for TNumber errors which can be emitted from many threads at once.
+//
+// The handlers live in an immutable snapshot. An emission reads the current snapshot without any lock and only
+// writes to the reader record of its own thread. Connecting or disconnecting (rare) copies the snapshot, publishes
+// the copy and frees the old one after every thread which might still use it has left its emission.
+// A thread is known to be done with the old snapshot if it isn't emitting, or if its emission began after the
+// new snapshot was published, which is told by the epoch recorded at the beginning of the emission.
+
+typedef struct
+{
+  guint            id;
+  TNumberErrorFunc func;
+  gpointer         user_data;
+} TNumberErrorHandler;
+
+typedef struct
+{
+  guint               n_handlers;
+  TNumberErrorHandler handlers[];
+} TNumberErrorSnapshot;
+
+// One per emitting thread, padded to a cache line so that emissions in different threads don't share a line.
+typedef struct _TNumberErrorReader
+{
+  guint                       epoch;   /* the epoch when the outermost emission began */
+  gint                        active;  /* TRUE during an emission */
+  guint                       nesting; /* used by the owner thread only */
+  struct _TNumberErrorReader *next;
+  char                        padding[64 - 3 * sizeof (guint) - sizeof (gpointer)];
+} TNumberErrorReader;
+
+static void t_number_error_reader_free (gpointer data);
+
+static TNumberErrorSnapshot *snapshot       = NULL;
+static guint                 epoch          = 0;
+static gint                  forward_signal = TRUE;
+static TNumberErrorReader   *readers        = NULL; /* protected by the writer lock */
+static guint                 last_id        = 0;    /* protected by the writer lock */
+static GPrivate              reader_key     = G_PRIVATE_INIT (t_number_error_reader_free);
+
+G_LOCK_DEFINE_STATIC (writer);
+
+// ------------ Readers --------------------------------------------------------------------------------------------- //
+
+static void
+t_number_error_reader_free (gpointer data)
+{
+  TNumberErrorReader **r;
+
+  G_LOCK (writer);
+  for (r = &readers; *r; r = &(*r)->next)
+    {
+      if (*r == data)
+        {
+          *r = (*r)->next;
+          break;
+        }
+    }
+  G_UNLOCK (writer);
+  g_free (data);
+}
+
+static TNumberErrorReader *
+t_number_error_get_reader (void)
+{
+  TNumberErrorReader *reader = g_private_get (&reader_key);
+
+  if (G_UNLIKELY (reader == NULL))
+    {
+      reader = g_new0 (TNumberErrorReader, 1);
+      G_LOCK (writer);
+      reader->next = readers;
+      readers      = reader;
+      G_UNLOCK (writer);
+      g_private_set (&reader_key, reader);
+    }
+  return reader;
+}
+
+void
+t_number_error_emit (TNumber *number, TNumberError error)
+{
+  g_return_if_fail (T_IS_NUMBER (number));
+
+  TNumberErrorReader   *reader = t_number_error_get_reader ();
+  TNumberErrorSnapshot *s;
+  guint                 i;
+
+  if (reader->nesting++ == 0)
+    {
+      g_atomic_int_set (&reader->epoch, g_atomic_int_get (&epoch));
+      g_atomic_int_set (&reader->active, TRUE);
+    }
+  s = g_atomic_pointer_get (&snapshot);
+  for (i = 0; s && i < s->n_handlers; ++i)
+    {
+      s->handlers[i].func (number, error, s->handlers[i].user_data);
+    }
+  if (--reader->nesting == 0)
+    {
+      g_atomic_int_set (&reader->active, FALSE);
+    }
+}
+
+// ------------ Writers --------------------------------------------------------------------------------------------- //
+
+static gboolean
+t_number_error_in_emission (void)
+{
+  TNumberErrorReader *reader = g_private_get (&reader_key);
+  return reader && reader->nesting > 0;
+}
+
+// Called with the writer lock held.
+static void
+t_number_error_publish (TNumberErrorSnapshot *new_snapshot)
+{
+  TNumberErrorSnapshot *old = g_atomic_pointer_get (&snapshot);
+  TNumberErrorReader   *r;
+  guint                 new_epoch;
+
+  g_atomic_pointer_set (&snapshot, new_snapshot);
+  new_epoch = (guint)g_atomic_int_add (&epoch, 1) + 1;
+  for (r = readers; r; r = r->next)
+    {
+      while (g_atomic_int_get (&r->active) && (gint)(g_atomic_int_get (&r->epoch) - new_epoch) < 0)
+        {
+          g_thread_yield ();
+        }
+    }
+  g_free (old);
+}
+
+// Handlers are called in the emitting thread, so they must be thread safe.
+// This function must not be called from a handler.
+guint
+t_number_error_connect (TNumberErrorFunc func, gpointer user_data)
+{
+  g_return_val_if_fail (func != NULL, 0);
+  g_return_val_if_fail (!t_number_error_in_emission (), 0);
+
+  TNumberErrorSnapshot *old, *new_snapshot;
+  guint                 n, id;
+
+  G_LOCK (writer);
+  old          = g_atomic_pointer_get (&snapshot);
+  n            = old ? old->n_handlers : 0;
+  new_snapshot = g_malloc (sizeof (TNumberErrorSnapshot) + (n + 1) * sizeof (TNumberErrorHandler));
+  if (n > 0)
+    {
+      memcpy (new_snapshot->handlers, old->handlers, n * sizeof (TNumberErrorHandler));
+    }
+  id                                  = ++last_id;
+  new_snapshot->handlers[n].id        = id;
+  new_snapshot->handlers[n].func      = func;
+  new_snapshot->handlers[n].user_data = user_data;
+  new_snapshot->n_handlers            = n + 1;
+  t_number_error_publish (new_snapshot);
+  G_UNLOCK (writer);
+  return id;
+}
+
+// This function must not be called from a handler.
+void
+t_number_error_disconnect (guint handler_id)
+{
+  g_return_if_fail (!t_number_error_in_emission ());
+
+  TNumberErrorSnapshot *old, *new_snapshot;
+  guint                 i, n;
+
+  G_LOCK (writer);
+  old = g_atomic_pointer_get (&snapshot);
+  for (i = 0; old && i < old->n_handlers && old->handlers[i].id != handler_id; ++i)
+    ;
+  if (old == NULL || i == old->n_handlers)
+    {
+      G_UNLOCK (writer);
+      g_warning ("t_number_error_disconnect: no handler with id %u.", handler_id);
+      return;
+    }
+  n            = old->n_handlers - 1;
+  new_snapshot = g_malloc (sizeof (TNumberErrorSnapshot) + n * sizeof (TNumberErrorHandler));
+  memcpy (new_snapshot->handlers, old->handlers, i * sizeof (TNumberErrorHandler));
+  memcpy (new_snapshot->handlers + i, old->handlers + i + 1, (n - i) * sizeof (TNumberErrorHandler));
+  new_snapshot->n_handlers = n;
+  t_number_error_publish (new_snapshot);
+  G_UNLOCK (writer);
+}
+
+// If forward is TRUE (default), errors are also emitted as GObject signals such as "div-by-zero".
+// Turning it off avoids the signal machinery completely when every listener uses this channel.
+void
+t_number_error_set_forward_signal (gboolean forward)
+{
+  g_atomic_int_set (&forward_signal, forward ? TRUE : FALSE);
+}
+
+gboolean
+t_number_error_get_forward_signal (void)
+{
+  return g_atomic_int_get (&forward_signal);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "tnumber.h"
+#include <glib-object.h>
+
+typedef enum
+{
+  T_NUMBER_ERROR_DIV_BY_ZERO
+} TNumberError;
+
+typedef void (*TNumberErrorFunc) (TNumber *number, TNumberError error, gpointer user_data);
+
+guint    t_number_error_connect (TNumberErrorFunc func, gpointer user_data);
+void     t_number_error_disconnect (guint handler_id);
+void     t_number_error_emit (TNumber *number, TNumberError error);
+void     t_number_error_set_forward_signal (gboolean forward);
+gboolean t_number_error_get_forward_signal (void);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "tdouble.h"
+#include "tint.h"
+#include <glib-object.h>
+
+// Direct access to the values of TInt and TDouble, which is a load or a store instead of a property call.
+// This header is opt-in. It makes the instance structures visible, so code including it must be rebuilt when
+// they change. The type checks go away if G_DISABLE_CHECKS is defined.
+// The setters don't emit "notify". Use them only for instances nobody watches, for example ones just created.
+
+struct _TInt
+{
+  TNumber parent;
+  int     value;
+};
+
+struct _TDouble
+{
+  TNumber parent;
+  double  value;
+};
+
+static inline int
+t_int_get_value (TInt *self)
+{
+  g_return_val_if_fail (T_IS_INT (self), 0);
+  return self->value;
+}
+
+static inline void
+t_int_set_value (TInt *self, int value)
+{
+  g_return_if_fail (T_IS_INT (self));
+  self->value = value;
+}
+
+static inline double
+t_double_get_value (TDouble *self)
+{
+  g_return_val_if_fail (T_IS_DOUBLE (self), 0.0);
+  return self->value;
+}
+
+static inline void
+t_double_set_value (TDouble *self, double value)
+{
+  g_return_if_fail (T_IS_DOUBLE (self));
+  self->value = value;
+}
+
+// The value of a TInt or TDouble as double.
+static inline double
+t_number_get_double (TNumber *self)
+{
+  if (T_IS_INT (self))
+    {
+      return T_INT (self)->value;
+    }
+  g_return_val_if_fail (T_IS_DOUBLE (self), 0.0);
+  return T_DOUBLE (self)->value;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "tnumberinline.h"
+#include <glib-object.h>
+
+// Statically typed arithmetic: t_int_add_int, t_int_add_double, t_double_add_int, t_double_add_double and so on
+// for add, sub, mul and div. The result has the type of the left operand, like t_number_add etc.
+// There is no class lookup and no type check, so the arguments must have the types in the function names.
+
+#define T_NUMBER_ARITH_OPS(X)                                                                                          \
+  X (add, +)                                                                                                           \
+  X (sub, -)                                                                                                           \
+  X (mul, *)                                                                                                           \
+  X (div, /)
+
+// A zero divisor (after the conversion to the type of self) emits "div-by-zero" and returns NULL.
+#define T_NUMBER_TYPED_OP(op_name, op, Self, self_prefix, ctype, Other, other_suffix)                                  \
+  static inline Self *self_prefix##_##op_name##_##other_suffix (Self *self, Other *other)                              \
+  {                                                                                                                    \
+    ctype value = (ctype)other->value;                                                                                 \
+    if (#op[0] == '/' && value == 0)                                                                                   \
+      {                                                                                                                \
+        t_number_div_by_zero ((TNumber *)self);                                                                        \
+        return NULL;                                                                                                   \
+      }                                                                                                                \
+    return self_prefix##_new_with_value (self->value op value);                                                        \
+  }
+
+#define T_NUMBER_TYPED_OPS(op_name, op)                                                                                \
+  T_NUMBER_TYPED_OP (op_name, op, TInt, t_int, int, TInt, int)                                                         \
+  T_NUMBER_TYPED_OP (op_name, op, TInt, t_int, int, TDouble, double)                                                   \
+  T_NUMBER_TYPED_OP (op_name, op, TDouble, t_double, double, TInt, int)                                                \
+  T_NUMBER_TYPED_OP (op_name, op, TDouble, t_double, double, TDouble, double)
+
+T_NUMBER_ARITH_OPS (T_NUMBER_TYPED_OPS)
@@ -0,0 +1,386 @@
+#include "tprofile.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef __GLIBC__
+#include <execinfo.h>
+#endif
+
+// Each constructed instance is put in a table while the profiler is on, so that the counts stay right even if
+// the profiler is turned on while instances exist: only instances in the table are counted when finalized.
+// Every sample_interval-th instance gets the backtrace of its construction. Call sites are counted by type and
+// backtrace, so the report shows which call sites have live instances, which is where leaks come from.
+
+#define T_PROFILE_DEPTH    16
+#define T_PROFILE_TOP_SITE 10
+
+typedef struct
+{
+  GType  type;
+  gsize  instance_size;
+  gint64 live;
+  gint64 peak_live;
+  gint64 total;
+  gint64 total_at_last_report;
+} TProfileType;
+
+typedef struct
+{
+  GType    type;
+  int      depth;
+  gpointer frames[T_PROFILE_DEPTH];
+  gint64   total;
+  gint64   live;
+} TProfileSite;
+
+gint t_profile_enabled = FALSE;
+
+static GMutex       profile_lock;
+static GHashTable  *types     = NULL; /* GType => TProfileType */
+static GHashTable  *sites     = NULL; /* TProfileSite => itself */
+static GHashTable  *instances = NULL; /* instance => TProfileSite, or &no_site if not sampled */
+static TProfileSite no_site;
+static gint         sample_interval; /* atomic, read without the lock */
+static guint        n_constructed;
+static gint64       live_bytes, peak_bytes;
+static gint64       enabled_time, last_report_time;
+
+static GMutex   dump_lock;
+static GCond    dump_cond;
+static GThread *dump_thread = NULL;
+static gboolean dump_stop;
+static guint    dump_interval;
+
+// ------------ Call sites ------------------------------------------------------------------------------------------ //
+
+static guint
+t_profile_site_hash (gconstpointer key)
+{
+  const TProfileSite *site = key;
+  guint               hash = (guint)site->type;
+  int                 i;
+
+  for (i = 0; i < site->depth; ++i)
+    {
+      hash = hash * 31 + GPOINTER_TO_UINT (site->frames[i]);
+    }
+  return hash;
+}
+
+static gboolean
+t_profile_site_equal (gconstpointer a, gconstpointer b)
+{
+  const TProfileSite *s = a, *t = b;
+
+  return s->type == t->type && s->depth == t->depth && memcmp (s->frames, t->frames, s->depth * sizeof (gpointer)) == 0;
+}
+
+static int
+t_profile_site_compare (gconstpointer a, gconstpointer b)
+{
+  const TProfileSite *s = *(TProfileSite *const *)a, *t = *(TProfileSite *const *)b;
+
+  return s->live < t->live ? 1 : s->live > t->live ? -1 : 0;
+}
+
+// ------------ Recording ------------------------------------------------------------------------------------------- //
+
+void
+t_profile_instance_new (GObject *instance)
+{
+  TProfileType *t;
+  TProfileSite  key, *site = &no_site;
+  GTypeQuery    query;
+  GType         type     = G_OBJECT_TYPE (instance);
+  gboolean      sampled  = FALSE;
+  guint         interval = (guint)g_atomic_int_get (&sample_interval);
+
+  if (interval > 0 && (guint)g_atomic_int_add (&n_constructed, 1) % interval == 0)
+    {
+      memset (&key, 0, sizeof key);
+      key.type = type;
+#ifdef __GLIBC__
+      key.depth = backtrace (key.frames, T_PROFILE_DEPTH);
+#endif
+      sampled = TRUE;
+    }
+
+  g_mutex_lock (&profile_lock);
+  if (types == NULL)
+    {
+      g_mutex_unlock (&profile_lock);
+      return;
+    }
+  if ((t = g_hash_table_lookup (types, GSIZE_TO_POINTER (type))) == NULL)
+    {
+      g_type_query (type, &query);
+      t                = g_new0 (TProfileType, 1);
+      t->type          = type;
+      t->instance_size = query.instance_size;
+      g_hash_table_insert (types, GSIZE_TO_POINTER (type), t);
+    }
+  ++t->total;
+  t->peak_live = MAX (t->peak_live, ++t->live);
+  live_bytes += t->instance_size;
+  peak_bytes = MAX (peak_bytes, live_bytes);
+  if (sampled)
+    {
+      if ((site = g_hash_table_lookup (sites, &key)) == NULL)
+        {
+          site = g_memdup2 (&key, sizeof key);
+          g_hash_table_add (sites, site);
+        }
+      ++site->total;
+      ++site->live;
+    }
+  g_hash_table_insert (instances, instance, site);
+  g_mutex_unlock (&profile_lock);
+}
+
+void
+t_profile_instance_free (GObject *instance)
+{
+  TProfileType *t;
+  TProfileSite *site;
+
+  g_mutex_lock (&profile_lock);
+  if (instances && g_hash_table_lookup_extended (instances, instance, NULL, (gpointer *)&site))
+    {
+      t = g_hash_table_lookup (types, GSIZE_TO_POINTER (G_OBJECT_TYPE (instance)));
+      --t->live;
+      live_bytes -= t->instance_size;
+      if (site != &no_site)
+        {
+          --site->live;
+        }
+      g_hash_table_remove (instances, instance);
+    }
+  g_mutex_unlock (&profile_lock);
+}
+
+// ------------ Control --------------------------------------------------------------------------------------------- //
+
+// Turns the profiler on. Every sample_interval-th instance records its call site; 0 records none.
+// If the profiler is already on, only the interval is changed.
+void
+t_profile_enable (guint interval)
+{
+  g_mutex_lock (&profile_lock);
+  if (types == NULL)
+    {
+      types        = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+      sites        = g_hash_table_new_full (t_profile_site_hash, t_profile_site_equal, g_free, NULL);
+      instances    = g_hash_table_new (g_direct_hash, g_direct_equal);
+      live_bytes   = 0;
+      peak_bytes   = 0;
+      enabled_time = last_report_time = g_get_monotonic_time ();
+    }
+  g_atomic_int_set (&sample_interval, (gint)interval);
+  g_atomic_int_set (&t_profile_enabled, TRUE);
+  g_mutex_unlock (&profile_lock);
+}
+
+// Turns the profiler off and forgets everything it has recorded.
+void
+t_profile_disable (void)
+{
+  g_mutex_lock (&profile_lock);
+  g_atomic_int_set (&t_profile_enabled, FALSE);
+  g_clear_pointer (&instances, g_hash_table_unref);
+  g_clear_pointer (&sites, g_hash_table_unref);
+  g_clear_pointer (&types, g_hash_table_unref);
+  g_mutex_unlock (&profile_lock);
+}
+
+// Reads T_PROFILE and T_PROFILE_DUMP. The classes of TNumber and TStr call it at their initialization.
+void
+t_profile_init_from_env (void)
+{
+  static gsize initialized = 0;
+  const char  *s;
+
+  if (!g_once_init_enter (&initialized))
+    {
+      return;
+    }
+  if ((s = g_getenv ("T_PROFILE")) != NULL)
+    {
+      t_profile_enable ((guint)g_ascii_strtoull (s, NULL, 10));
+      if ((s = g_getenv ("T_PROFILE_DUMP")) != NULL && g_ascii_strtoull (s, NULL, 10) > 0)
+        {
+          t_profile_start_periodic_dump ((guint)g_ascii_strtoull (s, NULL, 10));
+        }
+    }
+  g_once_init_leave (&initialized, 1);
+}
+
+// ------------ Report ---------------------------------------------------------------------------------------------- //
+
+// Returns the number of live instances of type (exactly this type, not subclasses), or -1 if the profiler is off.
+gint64
+t_profile_get_live (GType type)
+{
+  TProfileType *t;
+  gint64        live = -1;
+
+  g_mutex_lock (&profile_lock);
+  if (types)
+    {
+      t    = g_hash_table_lookup (types, GSIZE_TO_POINTER (type));
+      live = t ? t->live : 0;
+    }
+  g_mutex_unlock (&profile_lock);
+  return live;
+}
+
+// Returns the peak of the memory of the instances (instance structures only), or -1 if the profiler is off.
+gint64
+t_profile_get_peak_bytes (void)
+{
+  gint64 peak;
+
+  g_mutex_lock (&profile_lock);
+  peak = types ? peak_bytes : -1;
+  g_mutex_unlock (&profile_lock);
+  return peak;
+}
+
+static void
+t_profile_append_sites (GString *report)
+{
+  GPtrArray     *list = g_ptr_array_new ();
+  GHashTableIter iter;
+  TProfileSite  *site;
+  char         **symbols;
+  guint          i;
+  int            j;
+
+  g_hash_table_iter_init (&iter, sites);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&site, NULL))
+    {
+      if (site->live > 0)
+        {
+          g_ptr_array_add (list, site);
+        }
+    }
+  g_ptr_array_sort (list, t_profile_site_compare);
+  g_string_append_printf (report, "call sites with live instances (1 in %u sampled):\n",
+                          (guint)g_atomic_int_get (&sample_interval));
+  for (i = 0; i < MIN (list->len, T_PROFILE_TOP_SITE); ++i)
+    {
+      site = g_ptr_array_index (list, i);
+      g_string_append_printf (report, "  %s: %" G_GINT64_FORMAT " live, %" G_GINT64_FORMAT " total\n",
+                              g_type_name (site->type), site->live, site->total);
+#ifdef __GLIBC__
+      symbols = backtrace_symbols (site->frames, site->depth);
+      for (j = 0; symbols && j < site->depth; ++j)
+        {
+          g_string_append_printf (report, "    %s\n", symbols[j]);
+        }
+      free (symbols);
+#else
+      (void)symbols;
+      (void)j;
+#endif
+    }
+  g_ptr_array_unref (list);
+}
+
+// Returns the report as a newly allocated string, or NULL if the profiler is off.
+char *
+t_profile_report (void)
+{
+  GString       *report;
+  GHashTableIter iter;
+  TProfileType  *t;
+  gint64         now;
+  double         elapsed, interval;
+
+  g_mutex_lock (&profile_lock);
+  if (types == NULL)
+    {
+      g_mutex_unlock (&profile_lock);
+      return NULL;
+    }
+  now      = g_get_monotonic_time ();
+  elapsed  = (now - enabled_time) / (double)G_TIME_SPAN_SECOND;
+  interval = MAX (now - last_report_time, 1) / (double)G_TIME_SPAN_SECOND;
+  report   = g_string_new (NULL);
+  g_string_append_printf (report, "t_profile: %.1f s, %" G_GINT64_FORMAT " bytes live, %" G_GINT64_FORMAT
+                          " bytes peak\n", elapsed, live_bytes, peak_bytes);
+  g_string_append_printf (report, "%-16s %12s %12s %12s %12s\n", "type", "live", "peak", "total", "new/s");
+  g_hash_table_iter_init (&iter, types);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&t))
+    {
+      g_string_append_printf (report, "%-16s %12" G_GINT64_FORMAT " %12" G_GINT64_FORMAT " %12" G_GINT64_FORMAT,
+                              g_type_name (t->type), t->live, t->peak_live, t->total);
+      g_string_append_printf (report, " %12.0f\n", (t->total - t->total_at_last_report) / interval);
+      t->total_at_last_report = t->total;
+    }
+  last_report_time = now;
+  if (g_atomic_int_get (&sample_interval) != 0)
+    {
+      t_profile_append_sites (report);
+    }
+  g_mutex_unlock (&profile_lock);
+  return g_string_free (report, FALSE);
+}
+
+// Prints the report to stderr.
+void
+t_profile_dump (void)
+{
+  char *report = t_profile_report ();
+
+  if (report)
+    {
+      g_printerr ("%s", report);
+      g_free (report);
+    }
+}
+
+static gpointer
+t_profile_dump_thread (gpointer data)
+{
+  gint64 end;
+
+  g_mutex_lock (&dump_lock);
+  while (!dump_stop)
+    {
+      end = g_get_monotonic_time () + dump_interval * G_TIME_SPAN_SECOND;
+      if (!g_cond_wait_until (&dump_cond, &dump_lock, end) && !dump_stop)
+        {
+          g_mutex_unlock (&dump_lock);
+          t_profile_dump ();
+          g_mutex_lock (&dump_lock);
+        }
+    }
+  g_mutex_unlock (&dump_lock);
+  return NULL;
+}
+
+// Prints the report every interval_seconds from a background thread.
+void
+t_profile_start_periodic_dump (guint interval_seconds)
+{
+  g_return_if_fail (interval_seconds > 0);
+
+  t_profile_stop_periodic_dump ();
+  dump_stop     = FALSE;
+  dump_interval = interval_seconds;
+  dump_thread   = g_thread_new ("t-profile-dump", t_profile_dump_thread, NULL);
+}
+
+void
+t_profile_stop_periodic_dump (void)
+{
+  if (dump_thread == NULL)
+    {
+      return;
+    }
+  g_mutex_lock (&dump_lock);
+  dump_stop = TRUE;
+  g_cond_signal (&dump_cond);
+  g_mutex_unlock (&dump_lock);
+  g_thread_join (dump_thread);
+  dump_thread = NULL;
+}
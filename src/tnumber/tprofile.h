@@ -0,0 +1,27 @@
+#pragma once
+
+#include <glib-object.h>
+
+// Instance profiler for TNumber and TStr (and their subclasses).
+// It is off by default and costs one atomic load per construction and finalization then.
+// It can be turned on with t_profile_enable or with the environment variables
+//   T_PROFILE=<n>        record the call site of every n-th instance (0 records none)
+//   T_PROFILE_DUMP=<s>   print the report to stderr every s seconds
+
+extern gint t_profile_enabled;
+
+#define T_PROFILE_ENABLED() G_UNLIKELY (g_atomic_int_get (&t_profile_enabled))
+
+void   t_profile_enable (guint sample_interval);
+void   t_profile_disable (void);
+void   t_profile_init_from_env (void);
+gint64 t_profile_get_live (GType type);
+gint64 t_profile_get_peak_bytes (void);
+char  *t_profile_report (void);
+void   t_profile_dump (void);
+void   t_profile_start_periodic_dump (guint interval_seconds);
+void   t_profile_stop_periodic_dump (void);
+
+/* called by the instrumented classes */
+void t_profile_instance_new (GObject *instance);
+void t_profile_instance_free (GObject *instance);
@@ -0,0 +1,23 @@
+#pragma once
+
+// Static tracepoints (USDT) of the provider "ttypes".
+// With <sys/sdt.h> (systemtap-sdt-dev) each probe is a nop instruction plus a note in the ELF file, so it costs
+// nothing until a tracer such as bpftrace attaches to it. Without the header, or with T_DISABLE_TRACE defined,
+// the probes are compiled out. See ttrace.bt for the probes and their arguments.
+
+#if !defined(T_DISABLE_TRACE) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define T_TRACE_SDT 1
+#endif
+#endif
+
+#ifdef T_TRACE_SDT
+#include <sys/sdt.h>
+#define T_TRACE1(name, a)       DTRACE_PROBE1 (ttypes, name, a)
+#define T_TRACE2(name, a, b)    DTRACE_PROBE2 (ttypes, name, a, b)
+#define T_TRACE3(name, a, b, c) DTRACE_PROBE3 (ttypes, name, a, b, c)
+#else
+#define T_TRACE1(name, a)       ((void)0)
+#define T_TRACE2(name, a, b)    ((void)0)
+#define T_TRACE3(name, a, b, c) ((void)0)
+#endif
@@ -0,0 +1,68 @@
+/* benchmark: the text path of TNumStr vs GVariant serialization of TNumber */
+
+#include "../tnumber/tdouble.h"
+#include "../tnumber/tint.h"
+#include "tnumstr.h"
+#include <glib-object.h>
+
+#define N_NUMBERS 1000000
+
+static void
+report (const char *name, gint64 start)
+{
+  double usec = (double)(g_get_monotonic_time () - start);
+  g_print ("%-24s %10.3f ms %8.1f ns/number\n", name, usec / 1000.0, usec * 1000.0 / N_NUMBERS);
+}
+
+int
+main (void)
+{
+  TNumber  **numbers = g_new (TNumber *, N_NUMBERS);
+  TNumStr   *numstr  = t_num_str_new ();
+  GPtrArray *result;
+  GVariant  *v;
+  gint64     start;
+  int        i;
+
+  for (i = 0; i < N_NUMBERS; ++i)
+    {
+      numbers[i] = i % 2 ? T_NUMBER (t_int_new_with_value (i)) : T_NUMBER (t_double_new_with_value (i * 0.25));
+    }
+
+  /* TNumber => string => TNumber */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_NUMBERS; ++i)
+    {
+      t_num_str_set_from_t_number (numstr, numbers[i]);
+      g_object_unref (t_num_str_get_t_number (numstr));
+    }
+  report ("text (TNumStr)", start);
+
+  /* TNumber => GVariant => TNumber */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N_NUMBERS; ++i)
+    {
+      v = g_variant_ref_sink (t_number_serialize (numbers[i]));
+      g_object_unref (t_number_deserialize (v));
+      g_variant_unref (v);
+    }
+  report ("GVariant (one by one)", start);
+
+  /* TNumber[] => GVariant a(yd) => TNumber[] */
+  start = g_get_monotonic_time ();
+  v     = g_variant_ref_sink (t_number_serialize_array (numbers, N_NUMBERS));
+  report ("GVariant array (write)", start);
+  start  = g_get_monotonic_time ();
+  result = t_number_deserialize_array (v);
+  report ("GVariant array (read)", start);
+  g_ptr_array_unref (result);
+  g_variant_unref (v);
+
+  for (i = 0; i < N_NUMBERS; ++i)
+    {
+      g_object_unref (numbers[i]);
+    }
+  g_free (numbers);
+  g_object_unref (numstr);
+  return 0;
+}
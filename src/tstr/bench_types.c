@@ -0,0 +1,55 @@
+/* benchmark: the cost of t_types_init and of the first request with and without it */
+/* usage: bench_types [--no-init | --background] */
+
+#include "../tnumber/tnumber.h"
+#include "tnumstr.h"
+#include "ttypes.h"
+#include <glib-object.h>
+#include <string.h>
+
+/* a typical request: parse a number and compute with it */
+static void
+request (void)
+{
+  TNumStr *numstr = t_num_str_new ();
+  TNumber *num, *sum;
+  char    *s;
+
+  t_str_set_string (T_STR (numstr), "123.5");
+  num = t_num_str_get_t_number (numstr);
+  sum = t_number_add (num, num);
+  s   = t_number_to_s (sum);
+  g_free (s);
+  g_object_unref (sum);
+  g_object_unref (num);
+  g_object_unref (numstr);
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *mode = argc > 1 ? argv[1] : "";
+  gint64      start, first, second;
+
+  if (strcmp (mode, "--background") == 0)
+    {
+      t_types_init_in_background ();
+      g_usleep (10000);
+    }
+  else if (strcmp (mode, "--no-init") != 0)
+    {
+      t_types_init ();
+    }
+  g_print ("t_types_init:   %" G_GINT64_FORMAT " us\n", t_types_init_get_time ());
+
+  start = g_get_monotonic_time ();
+  request ();
+  first = g_get_monotonic_time () - start;
+
+  start = g_get_monotonic_time ();
+  request ();
+  second = g_get_monotonic_time () - start;
+  g_print ("first request:  %" G_GINT64_FORMAT " us\n", first);
+  g_print ("second request: %" G_GINT64_FORMAT " us\n", second);
+  return 0;
+}
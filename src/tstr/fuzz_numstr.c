@@ -0,0 +1,87 @@
+/* fuzz target: t_num_str_classify against the state machine t_num_str_classify_reference,
+ * and t_num_str_parse_int/double against g_ascii_strtoll/strtod */
+/* libFuzzer: meson setup _fuzz -Dfuzz=true with CC=clang, then
+ *   $ _fuzz/fuzz_numstr corpus/
+ * AFL: build with CC=afl-clang-fast (without -Dfuzz), then
+ *   $ afl-fuzz -i corpus -o findings -- _build/fuzz_numstr @@
+ * Without libFuzzer, the program reads each file named by the arguments, or stdin if there is none,
+ * so it can also replay the inputs the fuzzers found. A difference aborts. */
+
+#include "tnumstr.h"
+#include <errno.h>
+#include <glib-object.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size);
+
+int
+LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+  const char *s    = (const char *)data;
+  num_type    type = t_num_str_classify (s, size);
+  char       *copy;
+  gint64      expected_int;
+  double      expected, d;
+  int         i;
+  gboolean    in_range;
+
+  if (type != t_num_str_classify_reference (s, size))
+    {
+      abort ();
+    }
+  if (type == t_none)
+    {
+      return 0;
+    }
+  copy = g_strndup (s, size);
+  if (type == t_int)
+    {
+      errno        = 0;
+      expected_int = g_ascii_strtoll (copy, NULL, 10);
+      in_range     = errno == 0 && G_MININT <= expected_int && expected_int <= G_MAXINT;
+      if (t_num_str_parse_int (s, size, &i) != in_range || (in_range && i != expected_int))
+        {
+          abort ();
+        }
+    }
+  expected = g_ascii_strtod (copy, NULL);
+  d        = t_num_str_parse_double (s, size);
+  if (memcmp (&d, &expected, sizeof d) != 0)
+    {
+      abort ();
+    }
+  g_free (copy);
+  return 0;
+}
+
+#ifndef T_FUZZ_LIBFUZZER
+int
+main (int argc, char **argv)
+{
+  char   *stdin_path[] = { argv[0], "/dev/stdin" };
+  GError *error        = NULL;
+  char   *contents;
+  gsize   len;
+  int     i;
+
+  if (argc == 1)
+    {
+      argc = 2;
+      argv = stdin_path;
+    }
+  for (i = 1; i < argc; ++i)
+    {
+      if (!g_file_get_contents (argv[i], &contents, &len, &error))
+        {
+          g_printerr ("%s\n", error->message);
+          g_error_free (error);
+          return 1;
+        }
+      LLVMFuzzerTestOneInput ((const uint8_t *)contents, len);
+      g_free (contents);
+    }
+  return 0;
+}
+#endif
@@ -0,0 +1,290 @@
+#include "tcsv.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// The file is read by a parser thread in large chunks. Fields are split in place and classified by
+// t_num_str_classify, then appended to the typed columns of a batch. Full batches are handed to the caller's
+// thread through a queue, and come back through another queue when the callback is done with them.
+// So the parser and the consumer work in parallel and at most T_CSV_N_BATCHES batches ever exist.
+
+#define T_CSV_BUFFER_SIZE (4 << 20)
+#define T_CSV_BATCH_ROWS  65536
+#define T_CSV_N_BATCHES   4
+
+G_DEFINE_QUARK (t-csv-error-quark, t_csv_error)
+
+typedef struct
+{
+  const char  *path;
+  gboolean     has_header;
+  guint        n_columns; /* decided by the first row */
+  TCsvBatch    batches[T_CSV_N_BATCHES];
+  GAsyncQueue *free; /* batches the parser can fill */
+  GAsyncQueue *full; /* batches waiting for the consumer */
+  GError      *error;
+} TCsvPipeline;
+
+/* pushed to the full queue after the last batch */
+static TCsvBatch t_csv_end;
+
+// ------------ Batches --------------------------------------------------------------------------------------------- //
+
+static void
+t_csv_batch_set_n_columns (TCsvBatch *batch, guint n_columns)
+{
+  guint i;
+
+  batch->n_columns = n_columns;
+  batch->columns   = g_new0 (TCsvColumn, n_columns);
+  for (i = 0; i < n_columns; ++i)
+    {
+      batch->columns[i].type    = t_int;
+      batch->columns[i].ints    = g_array_sized_new (FALSE, FALSE, sizeof (int), T_CSV_BATCH_ROWS);
+      batch->columns[i].doubles = g_array_sized_new (FALSE, FALSE, sizeof (double), T_CSV_BATCH_ROWS);
+    }
+}
+
+static void
+t_csv_batch_reset (TCsvBatch *batch)
+{
+  guint i;
+
+  batch->n_rows    = 0;
+  batch->n_invalid = 0;
+  for (i = 0; i < batch->n_columns; ++i)
+    {
+      batch->columns[i].type = t_int;
+      g_array_set_size (batch->columns[i].ints, 0);
+      g_array_set_size (batch->columns[i].doubles, 0);
+    }
+}
+
+static void
+t_csv_batch_clear (TCsvBatch *batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->n_columns; ++i)
+    {
+      g_array_free (batch->columns[i].ints, TRUE);
+      g_array_free (batch->columns[i].doubles, TRUE);
+    }
+  g_free (batch->columns);
+}
+
+static void
+t_csv_column_to_double (TCsvColumn *column)
+{
+  guint i;
+
+  for (i = 0; i < column->ints->len; ++i)
+    {
+      double d = g_array_index (column->ints, int, i);
+      g_array_append_val (column->doubles, d);
+    }
+  g_array_set_size (column->ints, 0);
+  column->type = t_double;
+}
+
+// field is NUL-terminated at field[len], or NULL if the row has no such field.
+static void
+t_csv_column_append (TCsvBatch *batch, TCsvColumn *column, const char *field, gsize len)
+{
+  num_type type = field ? t_num_str_classify (field, len) : t_none;
+  double   d;
+  int      i;
+
+  /* an int out of the range of int makes the column double, like t_num_str_get_t_number makes it a TDouble */
+  if (type == t_int && column->type == t_int && t_num_str_parse_int (field, len, &i))
+    {
+      g_array_append_val (column->ints, i);
+      return;
+    }
+  if (column->type == t_int)
+    {
+      t_csv_column_to_double (column);
+    }
+  if (type == t_none)
+    {
+      d = NAN;
+      ++batch->n_invalid;
+    }
+  else
+    {
+      /* the same conversion as t_num_str_get_t_number */
+      d = t_num_str_parse_double (field, len);
+    }
+  g_array_append_val (column->doubles, d);
+}
+
+// ------------ Parser ---------------------------------------------------------------------------------------------- //
+
+// The byte line[len] must be writable. Fields are split by replacing the delimiters with NUL.
+static void
+t_csv_parse_line (TCsvPipeline *p, TCsvBatch **batch, char *line, gsize len)
+{
+  char *field, *end, *line_end;
+  guint i;
+
+  if (len > 0 && line[len - 1] == '\r')
+    {
+      --len;
+    }
+  if (len == 0)
+    {
+      return;
+    }
+  line[len] = '\0';
+  if (p->n_columns == 0)
+    {
+      for (p->n_columns = 1, field = line; (field = strchr (field, ',')) != NULL; ++field)
+        {
+          ++p->n_columns;
+        }
+    }
+  if ((*batch)->n_columns == 0)
+    {
+      t_csv_batch_set_n_columns (*batch, p->n_columns);
+    }
+  field    = line;
+  line_end = line + len;
+  for (i = 0; i < p->n_columns; ++i)
+    {
+      if (field > line_end)
+        {
+          t_csv_column_append (*batch, &(*batch)->columns[i], NULL, 0);
+          continue;
+        }
+      if ((end = memchr (field, ',', line_end - field)) == NULL)
+        {
+          end = line_end;
+        }
+      *end = '\0';
+      t_csv_column_append (*batch, &(*batch)->columns[i], field, end - field);
+      field = end + 1;
+    }
+  if (++(*batch)->n_rows == T_CSV_BATCH_ROWS)
+    {
+      g_async_queue_push (p->full, *batch);
+      *batch = g_async_queue_pop (p->free);
+      t_csv_batch_reset (*batch);
+    }
+}
+
+static gpointer
+t_csv_parse_thread (gpointer data)
+{
+  TCsvPipeline *p    = data;
+  FILE         *fp   = fopen (p->path, "rb");
+  gboolean      skip = p->has_header;
+  gsize         size = T_CSV_BUFFER_SIZE, len = 0, start, n;
+  char         *buffer, *nl;
+  TCsvBatch    *batch;
+
+  if (fp == NULL)
+    {
+      int errsv = errno;
+      g_set_error (&p->error, T_CSV_ERROR, T_CSV_ERROR_IO, "Failed to open %s: %s", p->path, g_strerror (errsv));
+      g_async_queue_push (p->full, &t_csv_end);
+      return NULL;
+    }
+  /* one extra byte, so that the last line can be terminated in place */
+  buffer = g_malloc (size + 1);
+  batch  = g_async_queue_pop (p->free);
+  t_csv_batch_reset (batch);
+  for (;;)
+    {
+      n = fread (buffer + len, 1, size - len, fp);
+      len += n;
+      start = 0;
+      while ((nl = memchr (buffer + start, '\n', len - start)) != NULL)
+        {
+          if (skip)
+            {
+              skip = FALSE;
+            }
+          else
+            {
+              t_csv_parse_line (p, &batch, buffer + start, nl - (buffer + start));
+            }
+          start = nl - buffer + 1;
+        }
+      if (n == 0)
+        {
+          if (ferror (fp))
+            {
+              g_set_error (&p->error, T_CSV_ERROR, T_CSV_ERROR_IO, "Failed to read %s", p->path);
+            }
+          else if (start < len && !skip)
+            {
+              t_csv_parse_line (p, &batch, buffer + start, len - start);
+            }
+          break;
+        }
+      memmove (buffer, buffer + start, len - start);
+      len -= start;
+      /* a line longer than the buffer */
+      if (len == size)
+        {
+          size *= 2;
+          buffer = g_realloc (buffer, size + 1);
+        }
+    }
+  fclose (fp);
+  g_free (buffer);
+  if (batch->n_rows > 0)
+    {
+      g_async_queue_push (p->full, batch);
+    }
+  g_async_queue_push (p->full, &t_csv_end);
+  return NULL;
+}
+
+// ------------ API ------------------------------------------------------------------------------------------------- //
+
+// Reads a numeric CSV file and calls func for each batch in the caller's thread while the next batches are parsed.
+// The batch belongs to the reader and is only valid during the call.
+gboolean
+t_csv_read (const char *path, gboolean has_header, TCsvBatchFunc func, gpointer user_data, GError **error)
+{
+  g_return_val_if_fail (path != NULL, FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+
+  TCsvPipeline p;
+  GThread     *thread;
+  TCsvBatch   *batch;
+  gboolean     ok;
+  guint        i;
+
+  memset (&p, 0, sizeof p);
+  p.path       = path;
+  p.has_header = has_header;
+  p.free       = g_async_queue_new ();
+  p.full       = g_async_queue_new ();
+  for (i = 0; i < T_CSV_N_BATCHES; ++i)
+    {
+      g_async_queue_push (p.free, &p.batches[i]);
+    }
+  thread = g_thread_new ("t-csv-parser", t_csv_parse_thread, &p);
+  while ((batch = g_async_queue_pop (p.full)) != &t_csv_end)
+    {
+      func (batch, user_data);
+      g_async_queue_push (p.free, batch);
+    }
+  g_thread_join (thread);
+
+  ok = (p.error == NULL);
+  if (!ok)
+    {
+      g_propagate_error (error, p.error);
+    }
+  for (i = 0; i < T_CSV_N_BATCHES; ++i)
+    {
+      t_csv_batch_clear (&p.batches[i]);
+    }
+  g_async_queue_unref (p.free);
+  g_async_queue_unref (p.full);
+  return ok;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "tnumstr.h"
+#include <glib-object.h>
+
+#define T_CSV_ERROR (t_csv_error_quark ())
+
+typedef enum
+{
+  T_CSV_ERROR_IO
+} TCsvError;
+
+typedef struct
+{
+  num_type type;    /* t_int, or t_double if any field of the column in the batch isn't an integer */
+  GArray  *ints;    /* int values, used if type is t_int */
+  GArray  *doubles; /* double values, used if type is t_double */
+} TCsvColumn;
+
+// A batch holds consecutive rows of the file as typed columns.
+// Fields which aren't numbers and missing fields are stored as NaN, which makes the column t_double.
+typedef struct
+{
+  guint       n_rows;
+  guint       n_columns;
+  guint       n_invalid;
+  TCsvColumn *columns;
+} TCsvBatch;
+
+typedef void (*TCsvBatchFunc) (const TCsvBatch *batch, gpointer user_data);
+
+GQuark   t_csv_error_quark (void);
+gboolean t_csv_read (const char *path, gboolean has_header, TCsvBatchFunc func, gpointer user_data, GError **error);
@@ -1,6 +1,7 @@
 /* test for public methods and the notify signal for TStr and TNumStr */
 
 #include "../tnumber/tdouble.h"
+#include "../tcomparable/with_macro/tcomparable.h"
 #include "../tnumber/tint.h"
 #include "tnumstr.h"
 #include "tstr.h"
@@ -82,6 +83,23 @@ main (void)
     {
       g_free (s);
     }
+
+  /* test for TComparable: the cached hash must follow t_str_set_string */
+  if (!t_comparable_lt (T_COMPARABLE (str1), T_COMPARABLE (str2)))
+    {
+      g_print ("t_comparable_lt didn't work for TStr.\n");
+    }
+  t_str_set_string (str1, two);
+  if (!t_comparable_eq (T_COMPARABLE (str1), T_COMPARABLE (str2))
+      || t_comparable_hash (T_COMPARABLE (str1)) != t_comparable_hash (T_COMPARABLE (str2)))
+    {
+      g_print ("Equal TStr instances don't compare equal or have different hashes.\n");
+    }
+  t_str_set_string (str1, NULL);
+  if (!t_comparable_lt (T_COMPARABLE (str1), T_COMPARABLE (str2)))
+    {
+      g_print ("A NULL string isn't less than other strings.\n");
+    }
   if (str1)
     {
       g_object_unref (str1);
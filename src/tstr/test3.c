@@ -0,0 +1,121 @@
+/* test for TStore and TStoreWriter */
+
+#include "../tnumber/tdouble.h"
+#include "../tnumber/tint.h"
+#include "tstore.h"
+#include <stdio.h>
+#include <string.h>
+
+#define N_VALUES 1000
+
+static int failures = 0;
+
+static void
+check (gboolean condition, const char *message)
+{
+  if (!condition)
+    {
+      g_print ("%s\n", message);
+      ++failures;
+    }
+}
+
+int
+main (void)
+{
+  const char   *path    = "test3.tstore";
+  const char   *words[] = { "one", "", NULL, "three" };
+  TStoreWriter *writer;
+  TStore       *store;
+  GError       *error = NULL;
+  int           i;
+
+  /* write an int, a double and a string column */
+  writer = t_store_writer_new (path, &error);
+  if (writer == NULL)
+    {
+      g_print ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+  t_store_writer_begin_column (writer, T_STORE_INT);
+  for (i = 0; i < N_VALUES; ++i)
+    {
+      t_store_writer_append_int (writer, i - N_VALUES / 2);
+    }
+  t_store_writer_begin_column (writer, T_STORE_DOUBLE);
+  for (i = 0; i < N_VALUES; ++i)
+    {
+      TNumber *d = T_NUMBER (t_double_new_with_value (i * 0.5));
+      t_store_writer_append_t_number (writer, d);
+      g_object_unref (d);
+    }
+  t_store_writer_begin_column (writer, T_STORE_STR);
+  for (i = 0; i < G_N_ELEMENTS (words); ++i)
+    {
+      t_store_writer_append_string (writer, words[i]);
+    }
+  if (!t_store_writer_close (writer, &error))
+    {
+      g_print ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+
+  /* read it back */
+  store = t_store_new_from_file (path, &error);
+  if (store == NULL)
+    {
+      g_print ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+  check (t_store_get_n_columns (store) == 3, "The number of columns is wrong.");
+  check (t_store_get_column_type (store, 0) == T_STORE_INT, "Column 0 isn't an int column.");
+  check (t_store_get_column_type (store, 1) == T_STORE_DOUBLE, "Column 1 isn't a double column.");
+  check (t_store_get_column_type (store, 2) == T_STORE_STR, "Column 2 isn't a string column.");
+
+  gsize         length;
+  const gint32 *ints    = t_store_get_int_column (store, 0, &length);
+  const double *doubles = t_store_get_double_column (store, 1, NULL);
+
+  check (length == N_VALUES, "The length of the int column is wrong.");
+  for (i = 0; i < N_VALUES; ++i)
+    {
+      check (ints[i] == i - N_VALUES / 2, "An int value is wrong.");
+      check (doubles[i] == i * 0.5, "A double value is wrong.");
+    }
+
+  TNumber *num = t_store_get_t_number (store, 0, 3);
+  int      v;
+  g_object_get (num, "value", &v, NULL);
+  check (T_IS_INT (num) && v == 3 - N_VALUES / 2, "t_store_get_t_number didn't work.");
+  g_object_unref (num);
+
+  for (i = 0; i < G_N_ELEMENTS (words); ++i)
+    {
+      const char *s = t_store_get_string (store, 2, i);
+      check ((s == NULL && words[i] == NULL) || (s && words[i] && strcmp (s, words[i]) == 0),
+             "A string value is wrong.");
+    }
+
+  /* the TStr view keeps the store alive */
+  TStr *str = t_store_get_t_str (store, 2, 3);
+  g_object_unref (store);
+  char *s = t_str_get_string (str);
+  check (strcmp (s, "three") == 0, "t_store_get_t_str didn't work.");
+  g_free (s);
+  t_str_set_string (str, "four");
+  g_object_unref (str);
+
+  /* a file which isn't a TStore file is rejected */
+  FILE *fp = fopen (path, "wb");
+  fputs ("This is not a TStore file.\n", fp);
+  fclose (fp);
+  store = t_store_new_from_file (path, &error);
+  check (store == NULL && error != NULL && error->code == T_STORE_ERROR_FORMAT, "A broken file was accepted.");
+  g_clear_error (&error);
+
+  remove (path);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,325 @@
+/* differential test: t_num_str_classify against the state machine t_num_str_classify_reference,
+ * and t_num_str_parse_int/double against g_ascii_strtoll/strtod */
+/* usage: test_numstr [n_random]
+ * Every input is given as a slice of exactly its length, so that an overread shows up with ASan.
+ * At the end the throughput of the old and new implementations is printed. */
+
+#include "tnumstr.h"
+#include <errno.h>
+#include <glib-object.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_RANDOM     1000000
+#define N_EXHAUSTIVE 6
+#define CORPUS_SIZE  (16 << 20)
+
+static const char *t_name[] = { "t_none", "t_int", "t_double" };
+static int         n_checked, n_failed;
+
+static void
+report (const char *s, gsize len, const char *message)
+{
+  GString *escaped;
+  gsize    i;
+
+  if (n_failed++ >= 20)
+    {
+      return;
+    }
+  escaped = g_string_new (NULL);
+  for (i = 0; i < MIN (len, 64); ++i)
+    {
+      if (g_ascii_isgraph (s[i]))
+        {
+          g_string_append_c (escaped, s[i]);
+        }
+      else
+        {
+          g_string_append_printf (escaped, "\\x%02x", (guchar)s[i]);
+        }
+    }
+  g_print ("\"%s\" (%" G_GSIZE_FORMAT " bytes): %s\n", escaped->str, len, message);
+  g_string_free (escaped, TRUE);
+}
+
+/* s has the syntax and no NUL, so the copy is the same string */
+static void
+check_parse (const char *slice, gsize len, num_type type)
+{
+  char  *s = g_strndup (slice, len);
+  gint64 expected_int;
+  double expected, d;
+  int    i;
+
+  if (type == t_int)
+    {
+      errno        = 0;
+      expected_int = g_ascii_strtoll (s, NULL, 10);
+      if (errno == 0 && G_MININT <= expected_int && expected_int <= G_MAXINT)
+        {
+          if (!t_num_str_parse_int (slice, len, &i) || i != expected_int)
+            {
+              report (slice, len, "t_num_str_parse_int differs from g_ascii_strtoll");
+            }
+        }
+      else if (t_num_str_parse_int (slice, len, &i))
+        {
+          report (slice, len, "t_num_str_parse_int doesn't detect the overflow");
+        }
+    }
+  expected = g_ascii_strtod (s, NULL);
+  d        = t_num_str_parse_double (slice, len);
+  if (memcmp (&d, &expected, sizeof d) != 0)
+    {
+      report (slice, len, "t_num_str_parse_double differs from g_ascii_strtod");
+    }
+  g_free (s);
+}
+
+static void
+check (const char *s, gsize len)
+{
+  char    *slice = g_memdup2 (s, len ? len : 1);
+  num_type fast, reference;
+  char    *message;
+
+  fast      = t_num_str_classify (slice, len);
+  reference = t_num_str_classify_reference (slice, len);
+  if (fast != reference)
+    {
+      message = g_strdup_printf ("%s is expected, but t_num_str_classify returns %s", t_name[reference], t_name[fast]);
+      report (slice, len, message);
+      g_free (message);
+    }
+  else if (fast != t_none)
+    {
+      check_parse (slice, len, fast);
+    }
+  ++n_checked;
+  g_free (slice);
+}
+
+/* all the strings up to N_EXHAUSTIVE bytes over the bytes which matter, their neighbours and NUL */
+static void
+check_exhaustive (void)
+{
+  static const char bytes[] = { '0', '9', '+', '-', '.', '/', ':', 'e', '\0' };
+  char              s[N_EXHAUSTIVE];
+  int               index[N_EXHAUSTIVE];
+  int               len, i;
+
+  for (len = 0; len <= N_EXHAUSTIVE; ++len)
+    {
+      memset (index, 0, sizeof index);
+      for (;;)
+        {
+          for (i = 0; i < len; ++i)
+            {
+              s[i] = bytes[index[i]];
+            }
+          check (s, len);
+          for (i = 0; i < len && ++index[i] == G_N_ELEMENTS (bytes); ++i)
+            {
+              index[i] = 0;
+            }
+          if (i == len)
+            {
+              break;
+            }
+        }
+    }
+}
+
+/* long digit runs with one other byte at every position, many signs and embedded NULs */
+static void
+check_adversarial (void)
+{
+  static const char others[] = { '+', '-', '.', '/', ':', ' ', '\0', '\x80', '\xb9', '\xff' };
+  char             *s;
+  gsize             len, pos;
+  guint             i;
+
+  for (len = 1; len <= 80; ++len)
+    {
+      s = g_malloc (len);
+      memset (s, '7', len);
+      check (s, len);
+      for (pos = 0; pos < len; ++pos)
+        {
+          for (i = 0; i < G_N_ELEMENTS (others); ++i)
+            {
+              s[pos] = others[i];
+              check (s, len);
+            }
+          s[pos] = '7';
+        }
+      g_free (s);
+    }
+  s = g_malloc (100000);
+  memset (s, '1', 100000);
+  check (s, 100000);
+  s[99999] = '.';
+  check (s, 100000);
+  s[0] = '.';
+  check (s, 100000);
+  memset (s, '-', 100000);
+  check (s, 100000);
+  s[99999] = '1';
+  check (s, 100000);
+  g_free (s);
+  check ("1\0", 2);
+  check ("\0001", 2);
+  check ("12.5\0", 5);
+  check ("+\0.5", 4);
+}
+
+/* a random byte, mostly one of the bytes the syntax has */
+static char
+random_byte (GRand *rand)
+{
+  static const char common[] = "0123456789+-.";
+  int               r        = g_rand_int_range (rand, 0, 16);
+
+  return r < 13 ? common[r] : (char)g_rand_int_range (rand, 0, 256);
+}
+
+/* a random string in the syntax, with a random change sometimes */
+static gsize
+random_string (GRand *rand, char *s, gsize size)
+{
+  gsize len = 0, n, i;
+
+  if (g_rand_boolean (rand))
+    {
+      s[len++] = g_rand_boolean (rand) ? '+' : '-';
+    }
+  n = g_rand_int_range (rand, 0, 24);
+  for (i = 0; i < n; ++i)
+    {
+      s[len++] = '0' + g_rand_int_range (rand, 0, 10);
+    }
+  if (g_rand_boolean (rand))
+    {
+      s[len++] = '.';
+      n        = g_rand_int_range (rand, 0, 24);
+      for (i = 0; i < n; ++i)
+        {
+          s[len++] = '0' + g_rand_int_range (rand, 0, 10);
+        }
+    }
+  if (len > 0 && g_rand_int_range (rand, 0, 4) == 0)
+    {
+      s[g_rand_int_range (rand, 0, len)] = random_byte (rand);
+    }
+  g_assert (len <= size);
+  return len;
+}
+
+static void
+check_random (GRand *rand, int n)
+{
+  char  s[64];
+  gsize len, i;
+  int   j;
+
+  for (j = 0; j < n; ++j)
+    {
+      if (j % 2 == 0)
+        {
+          len = random_string (rand, s, sizeof s);
+        }
+      else
+        {
+          len = g_rand_int_range (rand, 0, sizeof s + 1);
+          for (i = 0; i < len; ++i)
+            {
+              s[i] = random_byte (rand);
+            }
+        }
+      check (s, len);
+    }
+}
+
+/* the conversion before t_num_str_parse_int/double (atoi and atof stop at the newline) */
+static double
+parse_libc (const char *s, gsize len, num_type type)
+{
+  return type == t_int ? atoi (s) : atof (s);
+}
+
+static double
+parse_numstr (const char *s, gsize len, num_type type)
+{
+  int i;
+
+  return type == t_int && t_num_str_parse_int (s, len, &i) ? i : t_num_str_parse_double (s, len);
+}
+
+/* the throughput over a corpus of random numbers (and a few other strings) separated by newlines */
+static void
+report_throughput (GRand *rand)
+{
+  static const char *names[] = { "t_num_str_classify_reference", "t_num_str_classify" };
+  num_type (*classify[]) (const char *s, gsize len) = { t_num_str_classify_reference, t_num_str_classify };
+  static const char *parse_names[] = { "atoi/atof", "t_num_str_parse_int/double" };
+  double (*parse[]) (const char *s, gsize len, num_type type) = { parse_libc, parse_numstr };
+  char    *corpus = g_malloc (CORPUS_SIZE);
+  gsize    size   = 0;
+  char    *p, *end, *nl;
+  guint    i, counts[3];
+  num_type type;
+  gint64   start;
+  double   sec, sum;
+
+  while (size + 64 < CORPUS_SIZE)
+    {
+      size += random_string (rand, corpus + size, 63);
+      corpus[size++] = '\n';
+    }
+  end = corpus + size;
+  for (i = 0; i < G_N_ELEMENTS (names); ++i)
+    {
+      memset (counts, 0, sizeof counts);
+      start = g_get_monotonic_time ();
+      for (p = corpus; p < end; p = nl + 1)
+        {
+          nl = memchr (p, '\n', end - p);
+          ++counts[classify[i](p, nl - p)];
+        }
+      sec = MAX (g_get_monotonic_time () - start, 1) / (double)G_TIME_SPAN_SECOND;
+      g_print ("%-30s %8.1f MB/s (%u none, %u int, %u double)\n", names[i], size / sec / 1e6, counts[t_none],
+               counts[t_int], counts[t_double]);
+    }
+  for (i = 0; i < G_N_ELEMENTS (parse_names); ++i)
+    {
+      sum   = 0.0;
+      start = g_get_monotonic_time ();
+      for (p = corpus; p < end; p = nl + 1)
+        {
+          nl = memchr (p, '\n', end - p);
+          if ((type = t_num_str_classify (p, nl - p)) != t_none)
+            {
+              sum += parse[i](p, nl - p, type);
+            }
+        }
+      sec = MAX (g_get_monotonic_time () - start, 1) / (double)G_TIME_SPAN_SECOND;
+      g_print ("%-30s %8.1f MB/s (classify and parse, sum %g)\n", parse_names[i], size / sec / 1e6, sum);
+    }
+  g_free (corpus);
+}
+
+int
+main (int argc, char **argv)
+{
+  GRand *rand = g_rand_new_with_seed (20240229);
+  int    n    = argc > 1 ? (int)g_ascii_strtoll (argv[1], NULL, 10) : N_RANDOM;
+
+  check_exhaustive ();
+  check_adversarial ();
+  check_random (rand, n);
+  g_print ("%d inputs checked, %d differences\n", n_checked, n_failed);
+  report_throughput (rand);
+  g_rand_free (rand);
+  return n_failed ? 1 : 0;
+}
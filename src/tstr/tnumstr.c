@@ -2,9 +2,9 @@
 #include "../tnumber/tdouble.h"
 #include "../tnumber/tint.h"
 #include "../tnumber/tnumber.h"
+#include "../tnumber/ttrace.h"
 #include "tstr.h"
-#include <ctype.h>
-#include <stdlib.h>
+#include <string.h>
 
 struct _TNumStr
 {
@@ -14,37 +14,35 @@ struct _TNumStr
 
 G_DEFINE_TYPE (TNumStr, t_num_str, T_TYPE_STR)
 
-static num_type
-t_num_str_string_type (const char *string)
+// The state machine which defines the syntax: [+-]? digit* ('.' digit*)?, with at least one digit if there's no
+// period. t_num_str_classify must give the same result for every input (see test_numstr.c and fuzz_numstr.c).
+num_type
+t_num_str_classify_reference (const char *s, gsize len)
 {
-  const char *t;
-  int         stat, input;
+  gsize i;
+  int   stat, input;
   /* state matrix */
-  int m[4][5] = { { 1, 2, 3, 6, 6 }, { 6, 2, 3, 6, 6 }, { 6, 2, 3, 4, 6 }, { 6, 3, 6, 5, 6 } };
+  static const int m[4][5] = { { 1, 2, 3, 6, 6 }, { 6, 2, 3, 6, 6 }, { 6, 2, 3, 4, 6 }, { 6, 3, 6, 5, 6 } };
 
-  if (string == NULL)
-    {
-      return t_none;
-    }
   stat = 0;
-  for (t = string;; ++t)
+  for (i = 0; i <= len; ++i)
     {
-      if (*t == '+' || *t == '-')
+      if (i == len)
+        {
+          input = 3;
+        }
+      else if (s[i] == '+' || s[i] == '-')
         {
           input = 0;
         }
-      else if (isdigit (*t))
+      else if (g_ascii_isdigit (s[i]))
         {
           input = 1;
         }
-      else if (*t == '.')
+      else if (s[i] == '.')
         {
           input = 2;
         }
-      else if (*t == '\0')
-        {
-          input = 3;
-        }
       else
         {
           input = 4;
@@ -52,7 +50,7 @@ t_num_str_string_type (const char *string)
 
       stat = m[stat][input];
 
-      if (stat >= 4 || *t == '\0')
+      if (stat >= 4)
         {
           break;
         }
@@ -72,6 +70,196 @@ t_num_str_string_type (const char *string)
     }
 }
 
+// Eight digits in x (loaded in any byte order): each byte is 0x30-0x39, so its high half is 3 and adding 6 doesn't
+// carry into it.
+static inline gboolean
+t_num_str_is_eight_digits (guint64 x)
+{
+  return ((x & G_GUINT64_CONSTANT (0xF0F0F0F0F0F0F0F0))
+          | (((x + G_GUINT64_CONSTANT (0x0606060606060606)) & G_GUINT64_CONSTANT (0xF0F0F0F0F0F0F0F0)) >> 4))
+         == G_GUINT64_CONSTANT (0x3333333333333333);
+}
+
+// Returns the position of the first byte in [p, end) which isn't a digit, or end.
+static inline const char *
+t_num_str_skip_digits (const char *p, const char *end)
+{
+  guint64 x;
+
+  while (end - p >= 8)
+    {
+      memcpy (&x, p, 8);
+      if (!t_num_str_is_eight_digits (x))
+        {
+          break;
+        }
+      p += 8;
+    }
+  while (p < end && g_ascii_isdigit (*p))
+    {
+      ++p;
+    }
+  return p;
+}
+
+// Classifies the first len bytes of s. s doesn't need to be NUL-terminated.
+// It scans the digits eight bytes at a time and gives the same result as t_num_str_classify_reference.
+num_type
+t_num_str_classify (const char *s, gsize len)
+{
+  const char *p = s, *end = s + len, *digits;
+  num_type    type;
+
+  T_TRACE2 (num_str_classify_entry, s, len);
+  if (p < end && (*p == '+' || *p == '-'))
+    {
+      ++p;
+    }
+  digits = p;
+  p      = t_num_str_skip_digits (p, end);
+  if (p == end)
+    {
+      type = p > digits ? t_int : t_none;
+    }
+  else if (*p == '.')
+    {
+      type = t_num_str_skip_digits (p + 1, end) == end ? t_double : t_none;
+    }
+  else
+    {
+      type = t_none;
+    }
+  T_TRACE1 (num_str_classify_return, type);
+  return type;
+}
+
+// ------------ Conversion ------------------------------------------------------------------------------------------ //
+
+// The powers of ten which are exact doubles.
+static const double t_num_str_pow10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                          1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// Parses the first len bytes of s, which t_num_str_classify classifies as t_int, to *value.
+// Returns FALSE and leaves *value if the number is out of the range of int. It doesn't depend on the locale.
+gboolean
+t_num_str_parse_int (const char *s, gsize len, int *value)
+{
+  const char *p = s, *end = s + len;
+  gboolean    negative = FALSE;
+  guint64     magnitude = 0;
+
+  if (p < end && (*p == '+' || *p == '-'))
+    {
+      negative = *p++ == '-';
+    }
+  for (; p < end; ++p)
+    {
+      magnitude = magnitude * 10 + (guint64)(*p - '0');
+      if (magnitude > (guint64)G_MAXINT + 1)
+        {
+          return FALSE;
+        }
+    }
+  if (magnitude > (guint64)G_MAXINT + negative)
+    {
+      return FALSE;
+    }
+  *value = negative ? (int)-(gint64)magnitude : (int)magnitude;
+  return TRUE;
+}
+
+// Parses the first len bytes of s, which t_num_str_classify classifies as t_int or t_double, to the nearest double,
+// the same as g_ascii_strtod. It doesn't depend on the locale.
+// If the significant digits fit in 2^53 and there are at most 22 digits after the period, both the digits and the
+// power of ten are exact doubles and one division gives the correctly rounded result. Other numbers (more than
+// 15-16 significant digits) are copied and converted by g_ascii_strtod.
+double
+t_num_str_parse_double (const char *s, gsize len)
+{
+  const char *p = s, *end = s + len;
+  gboolean    negative = FALSE, period = FALSE, digit = FALSE;
+  guint64     mantissa = 0;
+  int         n_digits = 0, exponent = 0;
+  char        buf[64], *copy;
+  double      d;
+
+  if (p < end && (*p == '+' || *p == '-'))
+    {
+      negative = *p++ == '-';
+    }
+  for (; p < end; ++p)
+    {
+      if (*p == '.')
+        {
+          period = TRUE;
+          continue;
+        }
+      digit = TRUE;
+      exponent -= period;
+      /* leading zeros */
+      if (mantissa == 0 && *p == '0')
+        {
+          continue;
+        }
+      if (++n_digits > 19)
+        {
+          break;
+        }
+      mantissa = mantissa * 10 + (guint64)(*p - '0');
+    }
+  if (p == end && mantissa <= G_GUINT64_CONSTANT (1) << 53 && -exponent < (int)G_N_ELEMENTS (t_num_str_pow10))
+    {
+      if (!digit)
+        {
+          return 0.0; /* "." or "-." like strtod */
+        }
+      d = (double)mantissa / t_num_str_pow10[-exponent];
+      return negative ? -d : d;
+    }
+  copy = len < sizeof buf ? buf : g_malloc (len + 1);
+  memcpy (copy, s, len);
+  copy[len] = '\0';
+  d = g_ascii_strtod (copy, NULL);
+  if (copy != buf)
+    {
+      g_free (copy);
+    }
+  return d;
+}
+
+// A TInt if the number fits in int, otherwise a TDouble (the wider type), or NULL for t_none.
+static TNumber *
+t_num_str_convert (const char *s, gsize len, num_type type)
+{
+  int i;
+
+  if (type == t_int && t_num_str_parse_int (s, len, &i))
+    {
+      return T_NUMBER (t_int_new_with_value (i));
+    }
+  else if (type != t_none)
+    {
+      return T_NUMBER (t_double_new_with_value (t_num_str_parse_double (s, len)));
+    }
+  return NULL;
+}
+
+// Classifies and converts the first len bytes of s, which don't need to be NUL-terminated, for example a field in
+// a larger buffer. Returns a new TInt or TDouble like t_num_str_get_t_number, or NULL if s isn't a number.
+TNumber *
+t_num_str_parse (const char *s, gsize len)
+{
+  g_return_val_if_fail (s != NULL || len == 0, NULL);
+
+  return t_num_str_convert (s, len, t_num_str_classify (s, len));
+}
+
+static num_type
+t_num_str_string_type (const char *string)
+{
+  return string ? t_num_str_classify (string, strlen (string)) : t_none;
+}
+
 static void
 t_num_str_real_set_string (TStr *self, const char *s)
 {
@@ -116,21 +304,9 @@ t_num_str_get_t_number (TNumStr *self)
 {
   g_return_val_if_fail (T_IS_NUM_STR (self), NULL);
 
-  char    *s = t_str_get_string (T_STR (self));
-  TNumber *tnum;
+  char    *s    = t_str_get_string (T_STR (self));
+  TNumber *tnum = s ? t_num_str_convert (s, strlen (s), self->type) : NULL;
 
-  if (self->type == t_int)
-    {
-      tnum = T_NUMBER (t_int_new_with_value (atoi (s)));
-    }
-  else if (self->type == t_double)
-    {
-      tnum = T_NUMBER (t_double_new_with_value (atof (s)));
-    }
-  else
-    {
-      tnum = NULL;
-    }
   g_free (s);
   return tnum;
 }
@@ -145,6 +321,18 @@ t_num_str_new_with_tnumber (TNumber *num)
   return numstr;
 }
 
+// The counterpart of t_str_serialize. The string is classified as usual.
+TNumStr *
+t_num_str_deserialize (GVariant *variant)
+{
+  g_return_val_if_fail (variant != NULL, NULL);
+  g_return_val_if_fail (g_variant_is_of_type (variant, G_VARIANT_TYPE_BYTESTRING), NULL);
+
+  TNumStr *numstr = t_num_str_new ();
+  t_str_set_string (T_STR (numstr), g_variant_get_bytestring (variant));
+  return numstr;
+}
+
 TNumStr *
 t_num_str_new (void)
 {
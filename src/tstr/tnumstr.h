@@ -15,8 +15,14 @@ typedef enum
   t_double
 } num_type;
 
+num_type t_num_str_classify (const char *s, gsize len);
+num_type t_num_str_classify_reference (const char *s, gsize len);
+gboolean t_num_str_parse_int (const char *s, gsize len, int *value);
+double   t_num_str_parse_double (const char *s, gsize len);
+TNumber *t_num_str_parse (const char *s, gsize len);
 int      t_num_str_get_string_type (TNumStr *self);
 void     t_num_str_set_from_t_number (TNumStr *self, TNumber *num);
 TNumber *t_num_str_get_t_number (TNumStr *self);
 TNumStr *t_num_str_new_with_tnumber (TNumber *num);
+TNumStr *t_num_str_deserialize (GVariant *variant);
 TNumStr *t_num_str_new (void);
@@ -0,0 +1,499 @@
+#include "tstore.h"
+#include "../tnumber/tdouble.h"
+#include "../tnumber/tint.h"
+#include "../tnumber/tnumberinline.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+// ------------ File format ----------------------------------------------------------------------------------------- //
+
+// header | column payload | column payload | ... | column directory
+//
+// Everything is stored in the byte order of the writer and each section starts at a multiple of 8 bytes,
+// so the mapped file can be read in place.
+// An int column is an array of gint32 and a double column is an array of double.
+// A string column is a heap of NUL-terminated strings followed by an index, which is an array of guint64 heap offsets.
+// The directory is written last, so the writer never needs to know the size of a column in advance.
+
+#define T_STORE_MAGIC       "TSTORE\0\0"
+#define T_STORE_VERSION     1
+#define T_STORE_BYTE_ORDER  0x01020304
+#define T_STORE_NULL_STRING G_MAXUINT64
+#define T_STORE_ALIGN       8
+#define T_STORE_BUFFER_SIZE (1 << 20)
+
+typedef struct
+{
+  char    magic[8];
+  guint32 version;
+  guint32 byte_order;
+  guint64 n_columns;
+  guint64 directory; /* file offset of the column directory */
+} TStoreHeader;
+
+typedef struct
+{
+  guint32 type;
+  guint32 reserved;
+  guint64 length;    /* number of values */
+  guint64 data;      /* file offset of the values or the string heap */
+  guint64 data_size; /* size of the values or the string heap */
+  guint64 index;     /* file offset of the string index (string columns only) */
+} TStoreColumn;
+
+G_DEFINE_QUARK (t-store-error-quark, t_store_error)
+
+// ------------ TStore ---------------------------------------------------------------------------------------------- //
+
+struct _TStore
+{
+  GObject             parent;
+  GMappedFile        *file;
+  const char         *contents;
+  gsize               size;
+  const TStoreColumn *columns;
+  guint               n_columns;
+};
+
+G_DEFINE_TYPE (TStore, t_store, G_TYPE_OBJECT)
+
+static void
+t_store_finalize (GObject *object)
+{
+  TStore *self = T_STORE (object);
+
+  if (self->file)
+    {
+      g_mapped_file_unref (self->file);
+    }
+  G_OBJECT_CLASS (t_store_parent_class)->finalize (object);
+}
+
+static void
+t_store_class_init (TStoreClass *class)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+  gobject_class->finalize     = t_store_finalize;
+}
+
+static void
+t_store_init (TStore *self)
+{
+}
+
+static gboolean
+t_store_range_is_valid (TStore *self, guint64 offset, guint64 size)
+{
+  return offset <= self->size && size <= self->size - offset;
+}
+
+static gboolean
+t_store_column_is_valid (TStore *self, const TStoreColumn *c)
+{
+  if (c->data % T_STORE_ALIGN != 0 || !t_store_range_is_valid (self, c->data, c->data_size))
+    {
+      return FALSE;
+    }
+  if (c->type == T_STORE_INT)
+    {
+      return c->data_size % sizeof (gint32) == 0 && c->data_size / sizeof (gint32) == c->length;
+    }
+  else if (c->type == T_STORE_DOUBLE)
+    {
+      return c->data_size % sizeof (double) == 0 && c->data_size / sizeof (double) == c->length;
+    }
+  else if (c->type == T_STORE_STR)
+    {
+      /* The heap ends with NUL, so every string starting inside the heap is terminated inside the heap. */
+      return (c->data_size == 0 || self->contents[c->data + c->data_size - 1] == '\0') && c->index % T_STORE_ALIGN == 0
+             && c->length <= self->size / sizeof (guint64)
+             && t_store_range_is_valid (self, c->index, c->length * sizeof (guint64));
+    }
+  else
+    {
+      return FALSE;
+    }
+}
+
+// Only the header and the directory are checked here. The cost doesn't depend on the number of values.
+static gboolean
+t_store_validate (TStore *self, const char *path, GError **error)
+{
+  const TStoreHeader *header = (const TStoreHeader *)self->contents;
+  guint               i;
+
+  if (self->size < sizeof (TStoreHeader) || memcmp (header->magic, T_STORE_MAGIC, sizeof header->magic) != 0)
+    {
+      g_set_error (error, T_STORE_ERROR, T_STORE_ERROR_FORMAT, "%s is not a TStore file.", path);
+      return FALSE;
+    }
+  if (header->byte_order != T_STORE_BYTE_ORDER)
+    {
+      g_set_error (error, T_STORE_ERROR, T_STORE_ERROR_FORMAT, "%s was written with a different byte order.", path);
+      return FALSE;
+    }
+  if (header->version != T_STORE_VERSION)
+    {
+      g_set_error (error, T_STORE_ERROR, T_STORE_ERROR_FORMAT, "%s has unsupported version %u.", path,
+                   header->version);
+      return FALSE;
+    }
+  if (header->n_columns > G_MAXUINT || header->directory % T_STORE_ALIGN != 0
+      || !t_store_range_is_valid (self, header->directory, header->n_columns * sizeof (TStoreColumn)))
+    {
+      g_set_error (error, T_STORE_ERROR, T_STORE_ERROR_FORMAT, "%s has a broken column directory.", path);
+      return FALSE;
+    }
+  self->columns   = (const TStoreColumn *)(self->contents + header->directory);
+  self->n_columns = (guint)header->n_columns;
+  for (i = 0; i < self->n_columns; ++i)
+    {
+      if (!t_store_column_is_valid (self, &self->columns[i]))
+        {
+          g_set_error (error, T_STORE_ERROR, T_STORE_ERROR_FORMAT, "%s has a broken column %u.", path, i);
+          return FALSE;
+        }
+    }
+  return TRUE;
+}
+
+static const TStoreColumn *
+t_store_get_column (TStore *self, guint column, gsize index)
+{
+  g_return_val_if_fail (T_IS_STORE (self), NULL);
+  g_return_val_if_fail (column < self->n_columns, NULL);
+  g_return_val_if_fail (index < self->columns[column].length, NULL);
+  return &self->columns[column];
+}
+
+TStore *
+t_store_new_from_file (const char *path, GError **error)
+{
+  g_return_val_if_fail (path != NULL, NULL);
+
+  GMappedFile *file = g_mapped_file_new (path, FALSE, error);
+  TStore      *store;
+
+  if (file == NULL)
+    {
+      return NULL;
+    }
+  store           = T_STORE (g_object_new (T_TYPE_STORE, NULL));
+  store->file     = file;
+  store->contents = g_mapped_file_get_contents (file);
+  store->size     = g_mapped_file_get_length (file);
+  if (!t_store_validate (store, path, error))
+    {
+      g_object_unref (store);
+      return NULL;
+    }
+  return store;
+}
+
+guint
+t_store_get_n_columns (TStore *self)
+{
+  g_return_val_if_fail (T_IS_STORE (self), 0);
+  return self->n_columns;
+}
+
+TStoreType
+t_store_get_column_type (TStore *self, guint column)
+{
+  g_return_val_if_fail (T_IS_STORE (self), T_STORE_NONE);
+  g_return_val_if_fail (column < self->n_columns, T_STORE_NONE);
+  return self->columns[column].type;
+}
+
+gsize
+t_store_get_column_length (TStore *self, guint column)
+{
+  g_return_val_if_fail (T_IS_STORE (self), 0);
+  g_return_val_if_fail (column < self->n_columns, 0);
+  return self->columns[column].length;
+}
+
+// The returned array points into the mapped file. It is valid as long as self is alive.
+const gint32 *
+t_store_get_int_column (TStore *self, guint column, gsize *length)
+{
+  g_return_val_if_fail (t_store_get_column_type (self, column) == T_STORE_INT, NULL);
+
+  if (length)
+    {
+      *length = self->columns[column].length;
+    }
+  return (const gint32 *)(self->contents + self->columns[column].data);
+}
+
+const double *
+t_store_get_double_column (TStore *self, guint column, gsize *length)
+{
+  g_return_val_if_fail (t_store_get_column_type (self, column) == T_STORE_DOUBLE, NULL);
+
+  if (length)
+    {
+      *length = self->columns[column].length;
+    }
+  return (const double *)(self->contents + self->columns[column].data);
+}
+
+const char *
+t_store_get_string (TStore *self, guint column, gsize index)
+{
+  const TStoreColumn *c = t_store_get_column (self, column, index);
+  guint64             offset;
+
+  g_return_val_if_fail (c != NULL && c->type == T_STORE_STR, NULL);
+
+  offset = ((const guint64 *)(self->contents + c->index))[index];
+  if (offset == T_STORE_NULL_STRING)
+    {
+      return NULL;
+    }
+  g_return_val_if_fail (offset < c->data_size, NULL);
+  return self->contents + c->data + offset;
+}
+
+TNumber *
+t_store_get_t_number (TStore *self, guint column, gsize index)
+{
+  const TStoreColumn *c = t_store_get_column (self, column, index);
+
+  if (c == NULL)
+    {
+      return NULL;
+    }
+  else if (c->type == T_STORE_INT)
+    {
+      return T_NUMBER (t_int_new_with_value (((const gint32 *)(self->contents + c->data))[index]));
+    }
+  else if (c->type == T_STORE_DOUBLE)
+    {
+      return T_NUMBER (t_double_new_with_value (((const double *)(self->contents + c->data))[index]));
+    }
+  else
+    {
+      return NULL;
+    }
+}
+
+// The string of the returned TStr is borrowed from the mapped file, which is kept alive by the TStr.
+TStr *
+t_store_get_t_str (TStore *self, guint column, gsize index)
+{
+  g_return_val_if_fail (t_store_get_column_type (self, column) == T_STORE_STR, NULL);
+
+  const char *s = t_store_get_string (self, column, index);
+  return s ? t_str_new_borrowed (s, G_OBJECT (self)) : t_str_new ();
+}
+
+// ------------ TStoreWriter ---------------------------------------------------------------------------------------- //
+
+struct _TStoreWriter
+{
+  FILE        *fp;
+  char        *path;
+  char        *buffer;
+  guint64      pos;
+  GArray      *columns; /* TStoreColumn */
+  TStoreColumn current; /* current.type is T_STORE_NONE when no column is open */
+  GArray      *index;   /* guint64 heap offsets of the current string column */
+  GError      *error;   /* the first error, reported by t_store_writer_close */
+};
+
+static void
+t_store_writer_set_io_error (TStoreWriter *self, int errsv)
+{
+  if (self->error == NULL)
+    {
+      g_set_error (&self->error, T_STORE_ERROR, T_STORE_ERROR_IO, "Failed to write %s: %s", self->path,
+                   g_strerror (errsv));
+    }
+}
+
+static void
+t_store_writer_write (TStoreWriter *self, const void *data, gsize size)
+{
+  if (self->error || size == 0)
+    {
+      return;
+    }
+  if (fwrite (data, 1, size, self->fp) != size)
+    {
+      t_store_writer_set_io_error (self, errno);
+      return;
+    }
+  self->pos += size;
+}
+
+static void
+t_store_writer_align (TStoreWriter *self)
+{
+  static const char zero[T_STORE_ALIGN] = { 0 };
+
+  t_store_writer_write (self, zero, (T_STORE_ALIGN - self->pos % T_STORE_ALIGN) % T_STORE_ALIGN);
+}
+
+static void
+t_store_writer_end_column (TStoreWriter *self)
+{
+  if (self->current.type == T_STORE_NONE)
+    {
+      return;
+    }
+  self->current.data_size = self->pos - self->current.data;
+  if (self->current.type == T_STORE_STR)
+    {
+      t_store_writer_align (self);
+      self->current.index = self->pos;
+      t_store_writer_write (self, self->index->data, self->index->len * sizeof (guint64));
+      g_array_set_size (self->index, 0);
+    }
+  g_array_append_val (self->columns, self->current);
+  self->current.type = T_STORE_NONE;
+}
+
+TStoreWriter *
+t_store_writer_new (const char *path, GError **error)
+{
+  g_return_val_if_fail (path != NULL, NULL);
+
+  FILE         *fp = fopen (path, "wb");
+  TStoreWriter *self;
+  TStoreHeader  header = { { 0 } };
+
+  if (fp == NULL)
+    {
+      int errsv = errno;
+      g_set_error (error, T_STORE_ERROR, T_STORE_ERROR_IO, "Failed to open %s: %s", path, g_strerror (errsv));
+      return NULL;
+    }
+  self               = g_new0 (TStoreWriter, 1);
+  self->fp           = fp;
+  self->path         = g_strdup (path);
+  self->buffer       = g_malloc (T_STORE_BUFFER_SIZE);
+  self->columns      = g_array_new (FALSE, FALSE, sizeof (TStoreColumn));
+  self->index        = g_array_new (FALSE, FALSE, sizeof (guint64));
+  self->current.type = T_STORE_NONE;
+  setvbuf (fp, self->buffer, _IOFBF, T_STORE_BUFFER_SIZE);
+  /* placeholder, rewritten by t_store_writer_close */
+  t_store_writer_write (self, &header, sizeof header);
+  return self;
+}
+
+void
+t_store_writer_begin_column (TStoreWriter *self, TStoreType type)
+{
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (type == T_STORE_INT || type == T_STORE_DOUBLE || type == T_STORE_STR);
+
+  t_store_writer_end_column (self);
+  t_store_writer_align (self);
+  memset (&self->current, 0, sizeof self->current);
+  self->current.type = type;
+  self->current.data = self->pos;
+}
+
+void
+t_store_writer_append_int (TStoreWriter *self, int value)
+{
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (self->current.type == T_STORE_INT);
+
+  gint32 v = value;
+  t_store_writer_write (self, &v, sizeof v);
+  ++self->current.length;
+}
+
+void
+t_store_writer_append_double (TStoreWriter *self, double value)
+{
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (self->current.type == T_STORE_DOUBLE);
+
+  t_store_writer_write (self, &value, sizeof value);
+  ++self->current.length;
+}
+
+void
+t_store_writer_append_string (TStoreWriter *self, const char *s)
+{
+  g_return_if_fail (self != NULL);
+  g_return_if_fail (self->current.type == T_STORE_STR);
+
+  guint64 offset = s ? self->pos - self->current.data : T_STORE_NULL_STRING;
+  g_array_append_val (self->index, offset);
+  if (s)
+    {
+      t_store_writer_write (self, s, strlen (s) + 1);
+    }
+  ++self->current.length;
+}
+
+void
+t_store_writer_append_t_number (TStoreWriter *self, TNumber *num)
+{
+  g_return_if_fail (T_IS_NUMBER (num));
+
+  if (T_IS_INT (num))
+    {
+      t_store_writer_append_int (self, t_int_get_value (T_INT (num)));
+    }
+  else if (T_IS_DOUBLE (num))
+    {
+      t_store_writer_append_double (self, t_double_get_value (T_DOUBLE (num)));
+    }
+}
+
+void
+t_store_writer_append_t_str (TStoreWriter *self, TStr *str)
+{
+  g_return_if_fail (T_IS_STR (str));
+
+  char *s = t_str_get_string (str);
+  t_store_writer_append_string (self, s);
+  if (s)
+    {
+      g_free (s);
+    }
+}
+
+// Writes the directory and the header, closes the file and frees self.
+gboolean
+t_store_writer_close (TStoreWriter *self, GError **error)
+{
+  g_return_val_if_fail (self != NULL, FALSE);
+
+  TStoreHeader header;
+  gboolean     ok;
+
+  t_store_writer_end_column (self);
+  t_store_writer_align (self);
+  memcpy (header.magic, T_STORE_MAGIC, sizeof header.magic);
+  header.version    = T_STORE_VERSION;
+  header.byte_order = T_STORE_BYTE_ORDER;
+  header.n_columns  = self->columns->len;
+  header.directory  = self->pos;
+  t_store_writer_write (self, self->columns->data, self->columns->len * sizeof (TStoreColumn));
+  if (self->error == NULL && (fseek (self->fp, 0, SEEK_SET) != 0 || fwrite (&header, sizeof header, 1, self->fp) != 1))
+    {
+      t_store_writer_set_io_error (self, errno);
+    }
+  if (fclose (self->fp) != 0)
+    {
+      t_store_writer_set_io_error (self, errno);
+    }
+  ok = (self->error == NULL);
+  if (!ok)
+    {
+      g_propagate_error (error, self->error);
+    }
+  g_array_free (self->columns, TRUE);
+  g_array_free (self->index, TRUE);
+  g_free (self->buffer);
+  g_free (self->path);
+  g_free (self);
+  return ok;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../tnumber/tnumber.h"
+#include "tstr.h"
+#include <glib-object.h>
+
+#define T_TYPE_STORE (t_store_get_type ())
+
+G_DECLARE_FINAL_TYPE (TStore, t_store, T, STORE, GObject)
+
+#define T_STORE_ERROR (t_store_error_quark ())
+
+typedef enum
+{
+  T_STORE_ERROR_IO,
+  T_STORE_ERROR_FORMAT
+} TStoreError;
+
+typedef enum
+{
+  T_STORE_NONE,
+  T_STORE_INT,
+  T_STORE_DOUBLE,
+  T_STORE_STR
+} TStoreType;
+
+GQuark t_store_error_quark (void);
+
+// reader: the file is mapped and every value is borrowed from the mapping
+TStore       *t_store_new_from_file (const char *path, GError **error);
+guint         t_store_get_n_columns (TStore *self);
+TStoreType    t_store_get_column_type (TStore *self, guint column);
+gsize         t_store_get_column_length (TStore *self, guint column);
+const gint32 *t_store_get_int_column (TStore *self, guint column, gsize *length);
+const double *t_store_get_double_column (TStore *self, guint column, gsize *length);
+const char   *t_store_get_string (TStore *self, guint column, gsize index);
+TNumber      *t_store_get_t_number (TStore *self, guint column, gsize index);
+TStr         *t_store_get_t_str (TStore *self, guint column, gsize index);
+
+// writer: columns are written one after another through a buffered stream
+typedef struct _TStoreWriter TStoreWriter;
+
+TStoreWriter *t_store_writer_new (const char *path, GError **error);
+void          t_store_writer_begin_column (TStoreWriter *self, TStoreType type);
+void          t_store_writer_append_int (TStoreWriter *self, int value);
+void          t_store_writer_append_double (TStoreWriter *self, double value);
+void          t_store_writer_append_string (TStoreWriter *self, const char *s);
+void          t_store_writer_append_t_number (TStoreWriter *self, TNumber *num);
+void          t_store_writer_append_t_str (TStoreWriter *self, TStr *str);
+gboolean      t_store_writer_close (TStoreWriter *self, GError **error);
@@ -1,4 +1,9 @@
 #include "tstr.h"
+#include "../tcomparable/with_macro/tcomparable.h"
+#include "../tnumber/tmetrics.h"
+#include "../tnumber/tprofile.h"
+#include "../tnumber/ttrace.h"
+#include <string.h>
 
 enum
 {
@@ -13,10 +18,16 @@ static GParamSpec *str_properties[N_PROPERTIES] = {
 
 typedef struct
 {
-  char *string;
+  char    *string;
+  GObject *owner; /* non-NULL if string is borrowed from owner */
+  guint    hash;  /* the hash of string, valid if hash_valid */
+  gboolean hash_valid;
 } TStrPrivate;
 
-G_DEFINE_TYPE_WITH_PRIVATE (TStr, t_str, G_TYPE_OBJECT)
+static void t_comparable_interface_init (TComparableInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (TStr, t_str, G_TYPE_OBJECT,
+                         G_ADD_PRIVATE (TStr) G_IMPLEMENT_INTERFACE (T_TYPE_COMPARABLE, t_comparable_interface_init))
 
 static void
 t_str_set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
@@ -50,14 +61,28 @@ t_str_get_property (GObject *object, guint property_id, GValue *value, GParamSpe
 }
 
 static void
-t_str_real_set_string (TStr *self, const char *s)
+t_str_release_string (TStrPrivate *priv)
 {
-  TStrPrivate *priv = t_str_get_instance_private (self);
-
-  if (priv->string)
+  if (priv->owner)
+    {
+      g_object_unref (priv->owner);
+      priv->owner = NULL;
+    }
+  else if (priv->string)
     {
       g_free (priv->string);
     }
+  priv->string     = NULL;
+  priv->owner      = NULL;
+  priv->hash_valid = FALSE;
+}
+
+static void
+t_str_real_set_string (TStr *self, const char *s)
+{
+  TStrPrivate *priv = t_str_get_instance_private (self);
+
+  t_str_release_string (priv);
   priv->string = g_strdup (s);
 }
 
@@ -67,18 +92,69 @@ t_str_finalize (GObject *object)
   TStr        *self = T_STR (object);
   TStrPrivate *priv = t_str_get_instance_private (self);
 
-  if (priv->string)
+  if (T_PROFILE_ENABLED ())
     {
-      g_free (priv->string);
+      t_profile_instance_free (object);
     }
+  t_str_release_string (priv);
   G_OBJECT_CLASS (t_str_parent_class)->finalize (object);
 }
 
+static void
+t_str_constructed (GObject *object)
+{
+  if (T_PROFILE_ENABLED ())
+    {
+      t_profile_instance_new (object);
+    }
+  G_OBJECT_CLASS (t_str_parent_class)->constructed (object);
+}
+
+// NULL is less than any other string.
+static int
+t_str_comparable_cmp (TComparable *self, TComparable *other)
+{
+  if (!T_IS_STR (other))
+    {
+      g_signal_emit_by_name (self, "arg-error");
+      return -2;
+    }
+
+  TStrPrivate *priv   = t_str_get_instance_private (T_STR (self));
+  TStrPrivate *opriv  = t_str_get_instance_private (T_STR (other));
+  int          result = g_strcmp0 (priv->string, opriv->string);
+
+  return result > 0 ? 1 : result < 0 ? -1 : 0;
+}
+
+// The hash is computed once and kept until the string is released. NULL has the hash 0.
+static guint
+t_str_comparable_hash (TComparable *self)
+{
+  TStrPrivate *priv = t_str_get_instance_private (T_STR (self));
+
+  if (!priv->hash_valid)
+    {
+      priv->hash       = priv->string ? t_comparable_hash_bytes (priv->string, strlen (priv->string)) : 0;
+      priv->hash_valid = TRUE;
+    }
+  return priv->hash;
+}
+
+static void
+t_comparable_interface_init (TComparableInterface *iface)
+{
+  iface->cmp  = t_str_comparable_cmp;
+  iface->hash = t_str_comparable_hash;
+}
+
 static void
 t_str_init (TStr *self)
 {
   TStrPrivate *priv = t_str_get_instance_private (self);
-  priv->string = NULL;
+  priv->string     = NULL;
+  priv->owner      = NULL;
+  priv->hash_valid = FALSE;
 }
 
 static void
@@ -86,12 +162,14 @@ t_str_class_init (TStrClass *class)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
   gobject_class->finalize     = t_str_finalize;
+  gobject_class->constructed  = t_str_constructed;
   gobject_class->set_property = t_str_set_property;
   gobject_class->get_property = t_str_get_property;
   str_properties[PROP_STRING] = g_param_spec_string ("string", "str", "string", "", G_PARAM_READWRITE);
   g_object_class_install_properties (gobject_class, N_PROPERTIES, str_properties);
 
   class->set_string = t_str_real_set_string;
+  t_profile_init_from_env ();
 }
 
 // setter and getter
@@ -100,7 +178,9 @@ t_str_set_string (TStr *self, const char *s)
 {
   g_return_if_fail (T_IS_STR (self));
   TStrClass *class = T_STR_GET_CLASS (self);
+  T_TRACE2 (str_set_string_entry, self, s);
   class->set_string (self, s);
+  T_TRACE1 (str_set_string_return, self);
 }
 
 char *
@@ -111,15 +191,33 @@ t_str_get_string (TStr *self)
   return g_strdup (priv->string);
 }
 
+// Returns a floating GVariant of type "ay". A NULL string is serialized as an empty bytestring.
+GVariant *
+t_str_serialize (TStr *self)
+{
+  g_return_val_if_fail (T_IS_STR (self), NULL);
+  TStrPrivate *priv = t_str_get_instance_private (self);
+  return g_variant_new_bytestring (priv->string ? priv->string : "");
+}
+
+TStr *
+t_str_deserialize (GVariant *variant)
+{
+  g_return_val_if_fail (variant != NULL, NULL);
+  g_return_val_if_fail (g_variant_is_of_type (variant, G_VARIANT_TYPE_BYTESTRING), NULL);
+  return t_str_new_with_string (g_variant_get_bytestring (variant));
+}
+
 TStr *
 t_str_concat (TStr *self, TStr *other)
 {
   g_return_val_if_fail (T_IS_STR (self), NULL);
   g_return_val_if_fail (T_IS_STR (other), NULL);
 
-  char *s1 = t_str_get_string (self);
-  char *s2 = t_str_get_string (other);
-  char *s3;
+  gint64 start = T_METRICS_BEGIN (T_METRIC_STR_CONCAT);
+  char  *s1    = t_str_get_string (self);
+  char  *s2    = t_str_get_string (other);
+  char  *s3;
 
   if (s1 && s2)
     {
@@ -152,6 +250,7 @@ t_str_concat (TStr *self, TStr *other)
     {
       g_free (s3);
     }
+  T_METRICS_END (T_METRIC_STR_CONCAT, start);
   return str;
 }
 
@@ -161,6 +260,21 @@ t_str_new_with_string (const char *s)
   return T_STR (g_object_new (T_TYPE_STR, "string", s, NULL));
 }
 
+// The string isn't copied. The new instance keeps a reference to owner, which must keep s alive.
+// Setting another string afterwards drops the reference and stores a copy as usual.
+TStr *
+t_str_new_borrowed (const char *s, GObject *owner)
+{
+  g_return_val_if_fail (G_IS_OBJECT (owner), NULL);
+
+  TStr        *str  = t_str_new ();
+  TStrPrivate *priv = t_str_get_instance_private (str);
+
+  priv->string = (char *)s;
+  priv->owner  = g_object_ref (owner);
+  return str;
+}
+
 TStr *
 t_str_new (void)
 {
@@ -15,5 +15,10 @@ struct _TStrClass
 TStr *t_str_concat (TStr *self, TStr *other);
 void  t_str_set_string (TStr *self, const char *s);
 char *t_str_get_string (TStr *self);
+
 TStr *t_str_new_with_string (const char *s);
+TStr *t_str_new_borrowed (const char *s, GObject *owner);
 TStr *t_str_new (void);
+
+GVariant *t_str_serialize (TStr *self);
+TStr     *t_str_deserialize (GVariant *variant);
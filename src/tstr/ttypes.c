@@ -0,0 +1,81 @@
+#include "ttypes.h"
+#include "../tnumber/tdouble.h"
+#include "../tnumber/tint.h"
+#include "../tnumber/tnumber.h"
+#include "tnumstr.h"
+#include "tstore.h"
+#include "tstr.h"
+
+// Registering a type and initializing its class (properties, signals, vfuncs) happens at the first use.
+// t_types_init does it up front, so that the first request doesn't pay for it.
+
+typedef GType (*TTypeFunc) (void);
+
+typedef struct
+{
+  TTypeFunc get_type;
+  gboolean  instantiate; /* create and destroy an instance, which warms up the construction path */
+} TTypeEntry;
+
+static const TTypeEntry t_types[] = {
+  { t_number_get_type, FALSE },
+  { t_int_get_type, TRUE },
+  { t_double_get_type, TRUE },
+  { t_str_get_type, TRUE },
+  { t_num_str_get_type, TRUE },
+  { t_store_get_type, FALSE },
+};
+
+static gsize  t_types_initialized = 0;
+static gint64 t_types_time        = -1; /* written before t_types_initialized is set */
+
+// Registers all the types and keeps a reference to their classes, so the classes are never finalized.
+// It is done only once. If another thread is doing it, the function waits for it.
+void
+t_types_init (void)
+{
+  gint64 start;
+  GType  type;
+  gsize  i;
+
+  if (!g_once_init_enter (&t_types_initialized))
+    {
+      return;
+    }
+  start = g_get_monotonic_time ();
+  for (i = 0; i < G_N_ELEMENTS (t_types); ++i)
+    {
+      type = t_types[i].get_type ();
+      g_type_class_ref (type);
+      if (t_types[i].instantiate)
+        {
+          g_object_unref (g_object_new (type, NULL));
+        }
+    }
+  t_types_time = g_get_monotonic_time () - start;
+  g_debug ("t_types_init: %" G_GSIZE_FORMAT " types initialized in %" G_GINT64_FORMAT " us.", G_N_ELEMENTS (t_types),
+           t_types_time);
+  g_once_init_leave (&t_types_initialized, 1);
+}
+
+static gpointer
+t_types_init_thread (gpointer data)
+{
+  t_types_init ();
+  return NULL;
+}
+
+// Starts t_types_init in a new thread and returns at once.
+// The types can be used immediately; a thread which needs a class before it is ready just waits for it.
+void
+t_types_init_in_background (void)
+{
+  g_thread_unref (g_thread_new ("t-types-init", t_types_init_thread, NULL));
+}
+
+// Returns the time t_types_init took in microseconds, or -1 if it hasn't finished.
+gint64
+t_types_init_get_time (void)
+{
+  return g_atomic_pointer_get (&t_types_initialized) ? t_types_time : -1;
+}
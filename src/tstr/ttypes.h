@@ -0,0 +1,7 @@
+#pragma once
+
+#include <glib-object.h>
+
+void   t_types_init (void);
+void   t_types_init_in_background (void);
+gint64 t_types_init_get_time (void);
@@ -0,0 +1,87 @@
+require 'minitest/autorun'
+require 'fileutils'
+require 'tmpdir'
+require_relative '../lib/lib_pandoc.rb'
+
+class Test_lib_pandoc < Minitest::Test
+  include FileUtils
+
+  def convert_all dir, batch
+    ENV["PANDOC_BATCH"] = batch ? "1" : "0"
+    pandoc_queue("#{dir}/a.md", "#{dir}/a_#{batch}.html", "html", template: "#{dir}/template.html", title: "a title")
+    pandoc_queue("#{dir}/a.md", "#{dir}/a_#{batch}.tex", "latex", listings: true)
+    pandoc_queue("#{dir}/a.md", "#{dir}/b_#{batch}.tex", "latex")
+    pandoc_flush
+  ensure
+    ENV.delete("PANDOC_BATCH")
+  end
+
+  # A fake pandoc 2, which copies the input to the output slowly, so that the flushes overlap.
+  def with_slow_pandoc
+    path = ENV["PATH"]
+    Dir.mktmpdir do |bin|
+      File.write("#{bin}/pandoc", <<~'EOS')
+        #!/bin/sh
+        if [ "$1" = --version ]; then echo "pandoc 2.19"; exit 0; fi
+        while [ "$1" != -o ]; do shift; done
+        sleep 0.2
+        cp "$3" "$2"
+      EOS
+      chmod(0755, "#{bin}/pandoc")
+      ENV["PATH"] = "#{bin}:#{path}"
+      PANDOC[:version] = nil
+      yield
+    ensure
+      ENV["PATH"] = path
+      PANDOC[:version] = nil
+    end
+  end
+
+  # The html and tex tasks flush at the same time. Each flush must return after its own files are written.
+  def test_pandoc_flush_concurrent
+    with_slow_pandoc do
+      Dir.mktmpdir do |dir|
+        File.write("#{dir}/a.md", "# Title\n")
+        outputs = {"html" => [], "latex" => []}
+        3.times do |i|
+          outputs.each do |format, files|
+            files << "#{dir}/#{format}#{i}"
+            pandoc_queue("#{dir}/a.md", files.last, format)
+          end
+        end
+        # two flushes of latex: the second one waits for the first one
+        threads = %w[html latex latex].map do |format|
+          Thread.new { pandoc_flush(format); outputs[format].reject{|f| File.exist?(f)} }
+        end
+        threads.each{|t| assert_equal [], t.value}
+      end
+    end
+  end
+
+  # The batch conversion must write the same files as `pandoc -o`.
+  def test_pandoc_flush
+    skip "pandoc 3 or later is needed" unless system("pandoc --version > /dev/null 2>&1") && pandoc_batch?
+    Dir.mktmpdir do |dir|
+      File.write("#{dir}/a.md", <<~'EOS')
+        # Title
+
+        Text with `code` and a [link](sec1.html).
+
+        ~~~C
+        int main(int argc, char **argv) {
+        }
+        ~~~
+      EOS
+      File.write("#{dir}/template.html", "<title>$title$</title>\n$body$\n")
+      removed = false
+      pandoc_queue("#{dir}/a.md", "#{dir}/c.html", "html") { removed = true }
+      refute removed
+      convert_all(dir, true)
+      assert removed
+      convert_all(dir, false)
+      %w[a_%s.html a_%s.tex b_%s.tex].each do |name|
+        assert_equal File.read("#{dir}/#{name % false}"), File.read("#{dir}/#{name % true}")
+      end
+    end
+  end
+end
@@ -29,6 +29,24 @@ class Test_lib_renumber < Minitest::Test
       assert_equal t[1], t[3]
     end
   end
+  def test_renumber_links
+    temp_dir = get_temp_name()
+    Dir.mkdir temp_dir unless Dir.exist? temp_dir
+    File.write("#{temp_dir}/sec1.src.md", "See [Section 3](sec3.src.md) and [section 1](sec1.src.md).\n")
+    File.write("#{temp_dir}/sec3.src.md", "Back to [Section 1](sec1.src.md).\n")
+    File.utime(0, 0, "#{temp_dir}/sec3.src.md")
+    renumber ["#{temp_dir}/sec1.src.md", "#{temp_dir}/sec3.src.md"]
+    assert_equal "See [Section 2](sec2.src.md) and [section 1](sec1.src.md).\n", File.read("#{temp_dir}/sec1.src.md")
+    assert_equal "Back to [Section 1](sec1.src.md).\n", File.read("#{temp_dir}/sec2.src.md")
+    # the content of sec2 (old sec3) didn't change, so it isn't written
+    assert_equal 0, File.mtime("#{temp_dir}/sec2.src.md").to_i
+    # numbered already
+    File.utime(0, 0, "#{temp_dir}/sec1.src.md")
+    renumber ["#{temp_dir}/sec2.src.md", "#{temp_dir}/sec1.src.md"]
+    assert_equal 0, File.mtime("#{temp_dir}/sec1.src.md").to_i
+  ensure
+    remove_entry_secure(temp_dir)
+  end
   def get_temp_name
     "temp_"+Time.now.to_f.to_s.gsub(/\./,'')
   end
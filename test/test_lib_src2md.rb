@@ -787,11 +787,74 @@ class Test_lib_src_file < Minitest::Test
     assert_equal expected_c_gfm+expected_ruby_n_gfm, actual_c_ruby_gfm
     assert_equal expected_c_main_gfm, actual_c_main_gfm
   end
+  def test_included_source
+    src = <<~'EOS'
+    int
+    f (int a) (b)
+    {
+      x;
+    }
+    static void
+    g (int a,
+       int b)
+    {
+    }
+    void
+    h (void);
+    void
+    h (void)
+    { int x;
+    }
+    void
+    h (void) {
+
+    }
+    };
+    EOS
+    source = IncludedSource.new(src)
+    %w[f g h none].each do |name|
+      expected = src.match(/(.*\n#{name}\s*\(.*?\)\s*\{\s*\n(.|\n)*?^\}\s*?\n?)/).to_a[0]
+      assert_equal expected, source.function(name)
+    end
+    assert_equal "int\nf (int a) (b)\n{\n  x;\n}\n", source.function("f")
+    assert_nil source.function("g")
+    assert_equal "void\nh (void) {\n\n}\n", source.function("h")
+  end
   def test_at_shell
     actual = at_shell("@@@shell\necho abc\n@@@\n", ".")
     expected = "~~~\n$ echo abc\nabc\n~~~\n"
     assert_equal expected, actual
   end
+  def test_at_bench
+    actual = at_bench("@@@bench\necho abc\n@@@\n", ".")
+    lines = actual.lines
+    assert_equal "|command|wall (ms)|instructions|cache misses|mallocs|malloc bytes|\n", lines[0]
+    assert_equal "|:---|---:|---:|---:|---:|---:|\n", lines[1]
+    assert_match(/\A\|`echo abc`\|\d+\.\d\d\|([\d,]+|-)\|([\d,]+|-)\|-\|-\|\n\z/, lines[2])
+    assert_equal 3, lines.size
+  end
+  def test_shell_cache
+    temp = "temp"+Time.now.to_f.to_s.gsub(/\./,'')
+    mkdir_p("#{temp}/sub")
+    File.write("#{temp}/sub/a.txt", "abc\n")
+    clear_shell_cache
+    set_shell_cache_dir("#{temp}/cache")
+    expected = "~~~\n$ cd sub; cat a.txt\nabc\n~~~\n"
+    assert_equal expected, at_shell("@@@shell\ncd sub; cat a.txt\n@@@\n", temp)
+    assert_equal expected, at_shell("@@@shell\ncd sub; cat a.txt\n@@@\n", temp)
+    assert_match(/^@@@shell: 1 run, 1 cached\n.*cat a.txt: new\n\z/, shell_cache_report)
+    # a new process finds the output on the disk
+    clear_shell_cache
+    assert_equal expected, at_shell("@@@shell\ncd sub; cat a.txt\n@@@\n", temp)
+    assert_equal "@@@shell: 0 run, 1 cached\n", shell_cache_report
+    File.write("#{temp}/sub/a.txt", "def\n")
+    assert_equal "~~~\n$ cd sub; cat a.txt\ndef\n~~~\n", at_shell("@@@shell\ncd sub; cat a.txt\n@@@\n", temp)
+    assert_match(/#{temp}\/sub\/a.txt changed\n\z/, shell_cache_report)
+  ensure
+    set_shell_cache_dir(nil)
+    clear_shell_cache
+    remove_entry_secure(temp)
+  end
   # Change relative links in the secXX.src.md to the one in gfm/secXX.md, html/secXX.html or latex/secXX.tex
   # Example:
   #  src=>gfm:  [Section 1](sec1.src.md) => [Section 1](sec1.md)
@@ -881,6 +944,11 @@ class Test_lib_src_file < Minitest::Test
       dst_md["#{type}_image"] = File.read "#{dst_dir}/sample_image.md"
       chdir(cur_dir)
     end
+    # an intermediate file outside docs gets the links for docs
+    chdir(temp)
+    src2md "src/sample.src.md", "html", "work/sample.md"
+    dst_md["html_work"] = File.read "work/sample.md"
+    chdir(cur_dir)
     remove_entry_secure(temp)
     # If you want to see the difference
     # Diff::LCS.diff(files_src2md()[:sample_md_gfm].each_line.to_a, dst_md["gfm"].each_line.to_a).each do |array|
@@ -895,6 +963,7 @@ class Test_lib_src_file < Minitest::Test
     # end
     assert_equal files_src2md()[:sample_md_gfm], dst_md["gfm"]
     assert_equal files_src2md()[:sample_md_html], dst_md["html"]
+    assert_equal files_src2md()[:sample_md_html], dst_md["html_work"]
     assert_equal files_src2md()[:sample_md_latex], dst_md["latex"]
     assert_equal "![image](../src/image/image.png)\n", dst_md["gfm_image"]
     assert_equal "![image](image/image.png)\n", dst_md["html_image"]
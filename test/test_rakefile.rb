@@ -54,6 +54,28 @@ class Test_rakefile < Minitest::Test
     remove_entry_secure(temp_dir)
     assert_equal expected.sort, actual.sort
   end
+  def test_bench_examples
+    rakefile = File.read("../Rakefile")
+    eval rakefile.match(/^def bench_examples.*?^end\n/m)[0]
+    src = <<~'EOS'
+    executable('tnumber', corefiles, 'main.c', dependencies: gobjdep, install: false)
+    executable('bench_access', corefiles, 'bench_access.c', dependencies: gobjdep, install: false)
+    test1 = executable('test1', corefiles, 'test1.c', dependencies: gobjdep, install: false)
+    test_numstr = executable('test_numstr', corefiles, 'test_numstr.c', dependencies: gobjdep, install: false)
+    executable('fuzz_numstr', corefiles, 'fuzz_numstr.c', dependencies: gobjdep, install: false)
+    executable('tester', 'tester.c', dependencies: gobjdep, install: false)
+    executable(
+      'toupper1', 'toupper1.c', dependencies: gobjdep, install: false)
+    shared_module('tmalloccount', 'tmalloccount.c', install: false)
+    EOS
+    temp_dir = get_temp_name()
+    Dir.mkdir temp_dir unless Dir.exist? temp_dir
+    path = "#{temp_dir}/meson.build"
+    File.write(path, src)
+    actual = bench_examples(path)
+    remove_entry_secure(temp_dir)
+    assert_equal ["tnumber", "tester", "toupper1"], actual
+  end
   def get_temp_name
     "temp_"+Time.now.to_f.to_s.gsub(/\./,'')
   end